@@ -0,0 +1,129 @@
+/* A preloadable shim that enforces a buffering policy on the stderr of
+   programs that can not be modified, when it is not a console (POSIX).
+
+ MIT License
+
+ Copyright (c) 2021 Ioannis Kappas
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE. */
+
+/* usage: LD_PRELOAD=/path/to/stest-preload.so STEST_PRELOAD_POLICY=POLICY PROGRAM
+
+   When stderr (fd 2) is a pipe or a socket, it is switched at startup to POLICY, which is one of
+
+   unbuf    => unbuffered, every write goes out straight away.
+   lnbuf    => line buffered, flushed at each new line.
+   bytes:N  => fully buffered with a buffer of N bytes, flushed
+               whenever N bytes are pending.
+   us:T     => fully buffered, and flushed every T microseconds by a
+               thread of the shim.
+
+   The program's own attempts to change the buffering of stderr with
+   setvbuf(), setbuf(), setbuffer() or setlinebuf() are then ignored.
+   A policy that can not be applied is reported on stdout (fd 1).
+*/
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* set once the policy is in force */
+static bool _ENFORCED=false;
+
+static int (*real_SETVBUF)(FILE*, char*, int, size_t) = NULL;
+
+static void* flush_EVERY(void* _us)
+/* Flush stderr every _US microseconds, forever. */
+{
+  long us = (long)(intptr_t)_us;
+  struct timespec ts = { us/1000000, (us%1000000)*1000 };
+  for (;;)
+    {
+      nanosleep(&ts, NULL);
+      fflush(stderr);
+    }
+  return NULL;
+}
+
+__attribute__((constructor))
+static void preload_SETUP(void)
+/* Apply the STEST_PRELOAD_POLICY to stderr, if it is a pipe or a
+   socket. */
+{
+  real_SETVBUF = (int (*)(FILE*, char*, int, size_t)) dlsym(RTLD_NEXT, "setvbuf");
+  char const * policy = getenv("STEST_PRELOAD_POLICY");
+  if (!real_SETVBUF || !policy) return;
+
+  struct stat st;
+  if (fstat(2, &st) || !(S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode))) return;
+
+  int rc = -1;
+  long n = 0;
+  if (!strcmp(policy, "unbuf"))
+    rc = real_SETVBUF(stderr, NULL, _IONBF, 0);
+  else if (!strcmp(policy, "lnbuf"))
+    rc = real_SETVBUF(stderr, NULL, _IOLBF, BUFSIZ);
+  else if (sscanf(policy, "bytes:%ld", &n) == 1 && n > 0)
+    {
+      /* glibc ignores the size unless it is given the buffer too */
+      char* buf = malloc(n);
+      if (buf) rc = real_SETVBUF(stderr, buf, _IOFBF, n);
+    }
+  else if (sscanf(policy, "us:%ld", &n) == 1 && n > 0)
+    {
+      rc = real_SETVBUF(stderr, NULL, _IOFBF, BUFSIZ);
+      pthread_t thread;
+      if (!rc) rc = pthread_create(&thread, NULL, flush_EVERY, (void*)(intptr_t)n);
+      if (!rc) pthread_detach(thread);
+    }
+  // not to stderr, whose writes are what is being measured
+  if (rc) dprintf(STDOUT_FILENO, "stest-preload: :policy %s :not-applied\n", policy);
+  _ENFORCED = !rc;
+}
+
+int setvbuf(FILE* stream, char* buf, int mode, size_t size)
+{
+  if (_ENFORCED && stream == stderr) return 0;
+  if (!real_SETVBUF)
+    real_SETVBUF = (int (*)(FILE*, char*, int, size_t)) dlsym(RTLD_NEXT, "setvbuf");
+  return real_SETVBUF(stream, buf, mode, size);
+}
+
+void setbuf(FILE* stream, char* buf)
+{
+  setvbuf(stream, buf, buf ? _IOFBF : _IONBF, BUFSIZ);
+}
+
+void setbuffer(FILE* stream, char* buf, size_t size)
+{
+  setvbuf(stream, buf, buf ? _IOFBF : _IONBF, size);
+}
+
+void setlinebuf(FILE* stream)
+{
+  setvbuf(stream, NULL, _IOLBF, 0);
+}
@@ -0,0 +1,124 @@
+/* The C++ iostreams :to-stderr can write through with :stream cerr|clog
+   (see stderr-test.c).
+
+ MIT License
+
+ Copyright (c) 2021 Ioannis Kappas
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE. */
+
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#define _write write
+#endif
+
+/* A stream buffer writing to stderr's handle, in the buffer it is
+   given with pubsetbuf(), unbuffered when that is empty. libstdc++'s
+   own file buffers ignore pubsetbuf() once open, which the standard
+   streams always are. */
+class HANDLE_BUF : public std::streambuf {
+  bool write_ALL(char const * buf, std::streamsize len)
+  {
+    while (len > 0)
+      {
+	int wrote = _write(2, buf, (unsigned)len);
+	if (wrote <= 0) return false;
+	buf += wrote; len -= wrote;
+      }
+    return true;
+  }
+
+protected:
+  std::streambuf* setbuf(char* buffer, std::streamsize size) override
+  {
+    setp(buffer, buffer+size);
+    return this;
+  }
+
+  int sync() override
+  {
+    bool ok = write_ALL(pbase(), pptr()-pbase());
+    setp(pbase(), epptr());
+    return ok ? 0 : -1;
+  }
+
+  int_type overflow(int_type c) override
+  {
+    if (sync() == -1) return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    if (pptr() < epptr()) { *pptr() = ch; pbump(1); return c; }
+    return write_ALL(&ch, 1) ? c : traits_type::eof();
+  }
+
+  std::streamsize xsputn(char const * s, std::streamsize n) override
+  {
+    if (n <= epptr()-pptr())
+      {
+	memcpy(pptr(), s, n);
+	pbump((int)n);
+	return n;
+      }
+    // too large to buffer, goes out after what is held
+    if (sync() == -1) return 0;
+    if (n < epptr()-pbase()) return xsputn(s, n);
+    return write_ALL(s, n) ? n : 0;
+  }
+};
+
+static std::ostream* _OS = nullptr;
+
+extern "C" void iostream_OPEN(bool clog, bool synced, char* buffer, int buffer_size)
+/* Have `iostream_WRITE' write to std::clog when CLOG is set, or else to
+   std::cerr, which has unitbuf set and so is flushed after each write.
+
+   When SYNCED, the stream is left as is, in sync with stdio: its writes
+   go through the stdio stderr stream and its buffering. Otherwise
+   sync_with_stdio(false) is called and the stream is given a buffer of
+   its own, BUFFER of BUFFER-SIZE, unbuffered when 0, with pubsetbuf().
+*/
+{
+  _OS = clog ? &std::clog : &std::cerr;
+  if (synced) return;
+  std::ios_base::sync_with_stdio(false);
+  // never deleted, the stream is flushed at exit
+  HANDLE_BUF* buf = new HANDLE_BUF;
+  buf->pubsetbuf(buffer_size ? buffer : nullptr, buffer_size);
+  _OS->rdbuf(buf);
+}
+
+extern "C" size_t iostream_WRITE(char const * msg, size_t len)
+/* Write LEN chars of MSG to the stream `iostream_OPEN' chose, return
+   LEN, or 0 on error. */
+{
+  _OS->write(msg, (std::streamsize)len);
+  return _OS->good() ? len : 0;
+}
+
+extern "C" void iostream_FLUSH(void)
+/* Flush the stream `iostream_OPEN' chose, if any. */
+{
+  if (_OS) _OS->flush();
+}
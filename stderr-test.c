@@ -1,924 +1,6629 @@
-/* A tool to investigate the buffering behavior of stderr on MS-Windows.
-
- MIT License
-
- Copyright (c) 2021 Ioannis Kappas
-
- Permission is hereby granted, free of charge, to any person obtaining a copy
- of this software and associated documentation files (the "Software"), to deal
- in the Software without restriction, including without limitation the rights
- to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- copies of the Software, and to permit persons to whom the Software is
- furnished to do so, subject to the following conditions:
-
- The above copyright notice and this permission notice shall be included in all
- copies or substantial portions of the Software.
-
- THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
- AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
- SOFTWARE. */
-     
-#include <assert.h>
-#include <io.h>
-#include <fcntl.h>
-#include <limits.h>
-#include <stdbool.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <winsock2.h>
-#include <windows.h>
-
-
-#define _DEBUG_DO 0
-
-enum e_args {
-  e_S=INT_MIN, /* start of commands barrier */
-  eTO_STDERR, eTO_CHILD_STDERR, ePIPE,
-  ePIPE_HANDLE_TO_CHILD, eTO_HANDLE,
-  ePIPE_TO_CHILD_STDERR, eSOCK_TO_CHILD_STDERR,
-  e_E,         /* end of commands barrier */
-  eWRITE, eWRITE_NL,
-  ePIPE_SIZE, eREAD,
-  eUNBUF, eLNBUF, eFLBUF,
-  e_I,         /* end of identifiers barrier */
-};
-
-static char const * usage[] =
-  {"A utility to probe stderr's behavior on windows.",
-
-   /* The order of entries below should match the order of commands in `e_args' */
-   ":to-stderr :write|:write-nl COUNT [:unbuf|(:lnbuf|:flbuf BUFFER-SIZE)]"
-     "\n\twrite COUNT '$' characters to stderr (:write-nl will also write an \\n at the end). Optionally change stderr's mode to unbuffered (:unbuf),  line (:lnbuf) or fully (:flbuf) buffered using a new buffer of BUFFER-SIZE.",
-   ":to-child-stderr :write|:write-nl COUNT [:unbuf|(:lnbuf|:flbuf BUFFER-SIZE)]"
-     "\n\tCreate a child process and have it write to its stderr stream. Takes same options as :to-stderr.",
-   ":pipe :pipe-size SIZE :read RCOUNT :write WCOUNT"
-     "\n\tCreate a _pipe() of size SIZE, write WCOUNT '$' characters to the pipe's write endpoint and read RCOUNT characters from the pipe's read endpoint.",
-   ":pipe-handle-to-child :pipe-size SIZE :read RCOUNT :write WCOUNT"
-     "\n\tCreate a _pipe() of size SIZE. Also create a child process passing the write pipe's handle as a command line argument to it. The child will open the handle and write WCOUNT '$' characters to it. The parent process will attempt to read RCOUNT characters from the pipe's read's endpoint.",
-   ":to-handle HANDLE WRITE-COUNT"
-     "\n\thelper option to support :pipe-handle-to-child. Attempts to open HANDLE and write WRITE-COUNT '$' characters to it.",
-   ":pipe-to-child-stderr :pipe-size PSIZE :read RCOUNT :write|:write-nl WCOUNT [:unbuf|(:lnbuf|:flbuf BSIZE)]"
-     "\n\tCreate a _pipe() of size PSIZE. Then create a child process with its stderr redirected to the pipe's write endpoint. The parent process will attempt to read RCOUNT characters from the pipe's read endpoint. The child process will attempt to write to its stderr (see :to-stderr for information on the write and buffering mode options).",
-   ":sock-to-child-stderr :read RCOUNT :write|:write-nl WCOUNT [:unbuf|(:lnbuf|:flbuf BSIZE)]"
-     "\n\tCreate a pair of read and write sockets. Then create a child process with its stderr redirected to the write socket. The parent process will attempt to read RCOUNT characters from the read socket. The child process will attempt to write to its stderr (see :to-stderr for information on the write and buffering mode options)."
-  };
-
-/* helper macros to assist with safe e_args indexing */
-#define _CMD_INFO(C) usage[(C)-e_S]
-#define _IDN_ASRT(C) assert((C)>e_E&&(C)<e_I);
-
-/* variables and utility macros to assist with synchronizing logging
-   output (to stdout) between parent and child by using a named mutex
-   whose ID (i.e. name) is passed over to the child. */
-static DWORD _PID=-1;static char _CM=' ';static HANDLE _OUTMX=NULL;static char* _MX_ID=NULL;
-static char const * _RL="PARNT";
-#define RPT(FS, ...) {DWORD wr=WaitForSingleObject(_OUTMX, INFINITE);                \
-                      assert(wr==WAIT_OBJECT_0);                                     \
-		      printf("[RPT%c:%s] " FS,_CM,_RL  __VA_OPT__(,) __VA_ARGS__); \
-		      fflush(stdout);					             \
-		      DWORD ro=ReleaseMutex(_OUTMX); assert(ro);}
-#define _RPT_D(...) if (_DEBUG_DO) RPT(__VA_ARGS__)
-
-/* logging version of assert */
-#define ASSERT(COND) {bool cond=COND;     \
-    if (!cond) {RPT(":ASSERTION-FAILED"   \
-                    " %s :FILE %s, :LINE %d\n", #COND, __FILE__, __LINE__); abort(); }}
-
-bool args_PARSE(int argc, char const * argv[], int args[]);
-void log_SETUP(int argc, char const* argv[]);
-int strings_JOIN(int aistart, int total, char const * prefix,
-		 char const * argv[], char* buffer, int buffer_size);
-void pipe_test(int pipe_size, int write_count, int read_count);
-void pipe_handle_to_child(int pipe_size, int write_count, int read_count);
-void pipe_to_child_stderr(int pipe_size, int read_count, char const * cmdargs);
-void socket_to_child_stderr(int read_count, char const * cmdargs);
-
-
-
-int main(int argc, char const * argv[])
-{
-  int args[argc];
-  if (!args_PARSE(argc, argv, args)) return 1;
-  ASSERT(args[0] == argc-1);
-
-  log_SETUP(argc,argv);
-  
-  int ailast=-1; /* the index of the last argument considered */
-  const int argslen = args[++ailast];
-  
-  switch(args[++ailast])
-    {
-    case eTO_STDERR:
-      {
-	enum e_args msg_type = args[++ailast]; _IDN_ASRT(msg_type);
-	switch(msg_type) { case eWRITE: case eWRITE_NL: break; default: ASSERT(0); };
-
-	int write_count = args[++ailast];
-	
-	ASSERT(write_count<5000);
-
-	enum e_args mode=0; int buffer_size=1;
-	if (ailast<argslen)
-	  {
-	    mode=args[++ailast]; _IDN_ASRT(mode);
-	    switch (mode)
-	      {
-	      case eLNBUF: case eFLBUF:
-		ASSERT(ailast<argslen); buffer_size=args[++ailast]; break;
-	      case eUNBUF: break;
-	      default: ASSERT(0);
-	      }
-	    ASSERT(buffer_size<4096);
-	  }
-
-	ASSERT( ailast == argslen );
-
-        // must be created on the heap since it might be still used
-        // past this block when the program is exited and stderr is
-        // flushed.
-	char* buffer = calloc(buffer_size+1, sizeof(char)); 
-	if (mode)
-	  {
-	    int ret = setvbuf(stderr, buffer,
-			      mode==eUNBUF ? _IONBF :
-			      mode==eLNBUF ? _IOLBF :
-			      _IOFBF,
-			      buffer_size);
-	    ASSERT( !ret );
-	  }
-
-	int msg_len=write_count;
-	if (msg_type==eWRITE_NL) ++msg_len;
-	char msg[msg_len];
-	memset(msg, 0, sizeof(msg));
-	memset(msg, '$', msg_len);
-	if (msg_type==eWRITE_NL) msg[msg_len-1] = '\n';
-	
-	RPT(":writing-bytes %d\n", msg_len);
-	int wrote = fwrite(msg, sizeof(char), msg_len, stderr);
-	RPT(":wrote-bytes %d\n", wrote);
-
-	RPT(":exiting...\n");
-
-	return 0;
-      }
-    case eTO_CHILD_STDERR:
-      {
-	ASSERT( ailast+1 < argc );
-	char subcmd[] = ":to-stderr";
-	int cmdargs_size = strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
-	ASSERT(cmdargs_size<64);
-	char cmdargs[cmdargs_size];
-	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
-      
-	HANDLE child_SPAWN(char const * cmdargs, HANDLE stderr_handle);
-	HANDLE child = child_SPAWN(cmdargs, NULL);
-
-	WaitForSingleObject( child, INFINITE );
-	RPT(":child-exited\n");
-
-	return 0;
-      }
-    case ePIPE:
-      {
-	ASSERT( args[++ailast] == ePIPE_SIZE );
-	int pipe_size = args[++ailast];
-	ASSERT( args[++ailast] == eREAD );
-	int read_count = args[++ailast];
-	ASSERT( args[++ailast] == eWRITE );
-	int write_count = args[++ailast];
-	ASSERT(write_count < 5000);
-      
-	ASSERT( ailast == argslen );
-	
-	pipe_test(pipe_size, write_count, read_count);
-	return 0; 
-      }
-    case ePIPE_HANDLE_TO_CHILD:
-      {
-	ASSERT( args[++ailast] == ePIPE_SIZE );
-	int pipe_size = args[++ailast];
-	ASSERT( args[++ailast] == eREAD );
-	int read_count = args[++ailast];
-	ASSERT( args[++ailast] == eWRITE );
-	int write_count = args[++ailast];
-	ASSERT(write_count < 5000);
-      
-	ASSERT( ailast == argslen );
-      
-	pipe_handle_to_child(pipe_size, write_count, read_count);
-	return 0;
-      }
-    case eTO_HANDLE:
-      {
-	int arg_handle = args[++ailast];
-	DWORD write_count = args[++ailast];
-
-	ASSERT( ailast == argslen );
-	
-
-	HANDLE handle = (HANDLE)(UINT_PTR) arg_handle;
-
-	char msg[write_count+1];
-	memset(msg, 0, sizeof(msg));
-	memset(msg, '$', sizeof(char)*write_count);
-
-	RPT(":writing-bytes %ld\n", write_count);
-	DWORD wrote;
-	int retval = WriteFile(handle, msg, write_count, &wrote, NULL);
-	ASSERT( retval != 0 );
-	RPT(":wrote-bytes %ld\n", wrote);
-
-	RPT(":exiting...\n");
-
-	return 0;
-      }
-    case ePIPE_TO_CHILD_STDERR:
-      {
-	ASSERT( args[++ailast] == ePIPE_SIZE );
-	int pipe_size = args[++ailast];
-	ASSERT( args[++ailast] == eREAD );
-	int read_count = args[++ailast];
-
-	ASSERT( ailast+1 < argc );
-	
-	char subcmd[] = ":to-stderr";
-	int cmdargs_size=strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
-	ASSERT(cmdargs_size<64);
-	char cmdargs[cmdargs_size];
-	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
-      
-	pipe_to_child_stderr(pipe_size, read_count, cmdargs);
-	return 0;
-      }
-    case eSOCK_TO_CHILD_STDERR:
-      {
-	ASSERT( args[++ailast] == eREAD );
-	int read_count = args[++ailast];
-
-	ASSERT( ailast+1 < argc );
-	
-	char subcmd[] = ":to-stderr";
-	int cmdargs_size=strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
-	ASSERT(cmdargs_size<64);
-	char cmdargs[cmdargs_size];
-	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
-      
-	socket_to_child_stderr(read_count, cmdargs);
-	return 0;
-      }
-    default:
-      ASSERT(0);
-    }
-
-  return 0;
-
-}
-
-HANDLE child_SPAWN(char const * cmdargs, HANDLE err_handle)
-/* Spawn a new instance of the program with command line arguments
-   CMDARGS. Optionally redirect the new program's stderr to ERR_HANDLE
-   when set.
-   
-   Return the handle of the new process.
-*/
-{
-  STARTUPINFO start;
-  PROCESS_INFORMATION pi;
-
-  memset (&start, 0, sizeof (start));
-  start.cb = sizeof (start);
-  start.dwFlags = SW_HIDE;
-
-  /* A hack to pass the ID (i.e. name) of the logging
-     synchronization mutex to the child using the Reserved2 field.
-       
-     See "Pass arbitrary data to a child process!" in
-     http://www.catch22.net/tuts/undocumented-createprocess
-  */
-  int id_size = sizeof(DWORD)+strlen(_MX_ID)+1;
-  char buf[id_size]; memset(buf, 0, id_size);
-  strncpy(sizeof(DWORD)+buf, _MX_ID, id_size);
-  start.cbReserved2 = sizeof(buf);
-  start.lpReserved2 = (LPBYTE)buf;
-    
-  if (err_handle)
-    {
-      start.dwFlags |= STARTF_USESTDHANDLES;
-      start.hStdInput = GetStdHandle (STD_INPUT_HANDLE);
-      start.hStdOutput = GetStdHandle (STD_OUTPUT_HANDLE);
-
-      start.hStdError = err_handle;
-    }
-
-  TCHAR cmd[MAX_PATH];
-  GetModuleFileName(NULL, cmd, MAX_PATH);
-  int cmdline_size = 1;
-  cmdline_size+=snprintf(NULL, 0, "%s %s", cmd, cmdargs);
-  ASSERT(cmdline_size < 128);
-  char cmdline[cmdline_size];
-  snprintf(cmdline, cmdline_size, "%s %s", cmd, cmdargs);
-  _RPT_D(":parent/child-cmd %s\n", cmdline);
-  
-  int rc = CreateProcessA (NULL, cmdline, NULL, NULL, TRUE /* inherit handles? */,
-			   0,
-			   NULL, NULL, &start, &pi);
-  ASSERT( rc != 0 );
-
-  return pi.hProcess;
-}
-
-void pipe_test(int pipe_size, int write_count, int read_count)
-/* Create a _pipe() of PIPE_SIZE. Write WRITE-COUNT '$' chars to
-   pipe's write endpoint and then read READ-COUNT chars from pipe's
-   read endpoint. 
-*/
-{
-  char msg[write_count];
-  memset(msg, '$', sizeof(char)*write_count);
-  
-  enum { READ, WRITE };
-  int pfds[2];
-  int rc = _pipe (pfds, pipe_size, _O_NOINHERIT | _O_BINARY);
-  ASSERT( rc == 0 );
-
-  
-  RPT(":pipe-size %d :writing-bytes %d\n",
-	pipe_size, write_count);
-  int wrote_count = _write(pfds[WRITE], msg, write_count);
-  ASSERT( wrote_count == write_count);
-
-  char read_buffer[ read_count+1 ];
-  memset(read_buffer, 0, read_count+1);
-    
-  RPT(":reading-bytes %d\n",
-	read_count);
-  int read = _read(pfds[READ], read_buffer, read_count);
-
-  RPT(":read-bytes %d :read-chars %s\n",
-	read, read_buffer);
-
-  _close(pfds[READ]);
-  _close(pfds[WRITE]);
-}
-      
-void pipe_handle_to_child(int pipe_size, int write_count, int read_count)
-/* Create a _pipe() of PIPE_SIZE. Spawn a child passing the pipe's
-   write handle as command line argument to the child. The child
-   writes WRITE-COUNT '$' chars to the write handle while the parent
-   reads READ-COUNT chars. 
-*/
-{
-  enum { READ, WRITE };
-  int pfds[2];
-  int rc = _pipe (pfds, pipe_size, _O_NOINHERIT | _O_BINARY);
-  ASSERT( rc == 0 );
-  HANDLE write_handle = (HANDLE) _get_osfhandle (pfds[WRITE]);
-  {
-    HANDLE parent = GetCurrentProcess ();
-    int retval = DuplicateHandle (parent,
-				  (HANDLE) _get_osfhandle (pfds[WRITE]),
-				  parent,
-				  &write_handle,
-				  0,
-				  TRUE,
-				  DUPLICATE_SAME_ACCESS);
-    ASSERT( retval != 0 );
-    _close(pfds[WRITE]);
-  }
-
-      
-  int cmdargs_size = 1;
-  cmdargs_size+=snprintf(NULL, 0, ":to-handle %lld %d",
-			 (UINT_PTR)write_handle, write_count);
-  ASSERT(cmdargs_size < 32);
-  char cmdargs[cmdargs_size];
-  snprintf(cmdargs, cmdargs_size, ":to-handle %lld %d",
-	   (UINT_PTR)write_handle, write_count);
-
-  HANDLE child = child_SPAWN(cmdargs, NULL); ASSERT ( child );
-  
-  char read_buffer[ read_count+1 ];
-  memset(read_buffer, 0, read_count+1);
-    
-  RPT(":pipe-size %d :reading-bytes %d\n",
-	pipe_size,  read_count);
-  int read = _read(pfds[READ], read_buffer, read_count);
-
-  RPT(":read-bytes %d :read-chars %s\n",
-	read, read_buffer); fflush(stdout);
- 
-  WaitForSingleObject(child, INFINITE);
-  RPT(":child-exited\n");
-
-  _close(pfds[READ]);
-    
-}
-
-
-void pipe_to_child_stderr(int pipe_size, int read_count, char const * cmdargs)
-/* Create a _pipe() of PIPE-SIZE. Spawn a new child process with
-   command line arguments CMDARGS, redirecting its stderr to the
-   pipe's write endpoint. The parent reads READ-COUNT chars from the
-   pipe's read endpoint. 
-*/
-{
-  enum { READ, WRITE };
-  int pfds[2];
-  int rc = _pipe (pfds, pipe_size, _O_NOINHERIT | _O_BINARY);
-  ASSERT( rc == 0 );
-  HANDLE write_handle = (HANDLE) _get_osfhandle (pfds[WRITE]);
-  {
-    HANDLE parent = GetCurrentProcess ();
-    int retval = DuplicateHandle (parent,
-				  (HANDLE) _get_osfhandle (pfds[WRITE]),
-				  parent,
-				  &write_handle,
-				  0,
-				  TRUE,
-				  DUPLICATE_SAME_ACCESS);
-    ASSERT( retval != 0 );
-    _close(pfds[WRITE]);	  
-  }
-
-  HANDLE child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
-
-  char read_buffer[ read_count+1 ];
-  memset(read_buffer, 0, read_count+1);
-    
-  RPT(":pipe-size %d, :read-req-bytes %d\n",
-	pipe_size, read_count);
-  int read = _read(pfds[READ], read_buffer, read_count);
-
-  RPT(":read-bytes %d :read-chars %s\n",
-	read, read_buffer); fflush(stdout);
-  
-  // wait for child to exit
-  WaitForSingleObject(child, INFINITE );
-  RPT(":child-exited\n");
-
-  _close(pfds[READ]);
-}
-
-struct THREAD_ARGS {
-  SOCKET socket_read;
-  int read_count;
-};
-
-DWORD socket_READ(LPVOID _args)
-/* read _ARGS.read_count chars from socket _ARGS.socket_read. _ARGS is
-   of type `THREAD_ARGS'. 
-*/
-{
-  struct THREAD_ARGS* args = (struct THREAD_ARGS*) _args;
-  ASSERT(args->read_count<5000);
-  
-  _RPT_D(":socket-read :listening...\n");
-  listen(args->socket_read , 1);
-
-  struct sockaddr_in client;
-  
-  int size = sizeof(struct sockaddr_in);
-  _RPT_D(":socket-read :accepting...\n");
-  SOCKET socket = accept(args->socket_read , (struct sockaddr *)&client, &size);
-  ASSERT(socket!=INVALID_SOCKET);
-	
-  int buffer_size = 1+args->read_count; 
-  char read_buffer[buffer_size]; memset(read_buffer, 0, buffer_size);
-  RPT(":reading-bytes %d\n", args->read_count);
-  int recv_size = recv(socket, read_buffer, args->read_count, 0);
-  ASSERT(recv_size != SOCKET_ERROR);
-  
-  RPT(":read-bytes %d :read-chars %s\n", recv_size, read_buffer);
-  
-  _RPT_D(":thread-exiting...\n");
-
-  return 0;
-}
-
-void socket_to_child_stderr(int read_count, char const * cmdargs)
-/* Create a pair of read/write TCP sockets. The write socket is
-   created using the first available WSA TCP "protocol" which can make
-   the socket also act as a file handle. The write socket is
-   connected to the read socket.
-
-   Spawns a child process with command line arguments CMDARGS. The
-   child stderr is redirected to the write socket. 
-
-   It reads READ-COUNT characters from the read socket.
-*/
-{
-  WSADATA wsa;
-  int rc = WSAStartup(MAKEWORD(2,2),&wsa);
-  ASSERT(rc == 0);
-  
-  WSAPROTOCOL_INFO provider; memset(&provider, 0, sizeof(provider));
-  {
-    // locate the first TCP provider that can create a socket which
-    // can act as a file.
-    //
-    // see https://stackoverflow.com/questions/58324162/are-wsasockets-able-to-take-process-i-o-without-the-use-of-pipes
-    int protocol[] = { IPPROTO_TCP, 0 };
-
-    unsigned int buffer_size = 4096; /* a guess of an upper memory requirements */
-    BYTE buffer[buffer_size]; memset(&buffer, 0, sizeof(buffer));
-    WSAPROTOCOL_INFO* pinfo = (WSAPROTOCOL_INFO*)&buffer;
-    DWORD pinfo_size = sizeof(buffer);
-    _RPT_D(":tcp-providers-getting...\n");
-    int count = WSAEnumProtocols(protocol, pinfo, &pinfo_size);
-    ASSERT( pinfo_size<=buffer_size );
-    ASSERT(count > 0);
-    int iprovider = -1;
-    for (int i=0;i<count;i++)
-      {
-	_RPT_D(":provider %d :address-family %d :protocol %s :ifs? %s\n",
-	       i, pinfo[0].iAddressFamily, pinfo[i].szProtocol,
-	       pinfo[i].dwServiceFlags1 & XP1_IFS_HANDLES ? "true" : "false");
-	// keep a reference of the first one found
-	if (iprovider==-1
-	    && pinfo[i].dwServiceFlags1 & XP1_IFS_HANDLES) iprovider = i;
-      }
-
-    ASSERT(iprovider!=-1);
-    
-    provider=pinfo[iprovider];
-  }
-
-  RPT(":socket-provider-IFS-selected %s\n", provider.szProtocol);
-  SOCKET socket_write = WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, &provider, 0, 0 );
-  ASSERT(socket_write  != INVALID_SOCKET);
-
-  SOCKET socket_read = socket(AF_INET, SOCK_STREAM, 0 );
-  ASSERT(socket_read != INVALID_SOCKET);
-  
-  struct sockaddr_in server;
-  server.sin_family = AF_INET;
-  server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
-  server.sin_port = 0; // any available port
-  
-  _RPT_D(":socket-read :binding...\n");
-  rc = bind(socket_read ,(struct sockaddr *)&server , sizeof(server));
-  ASSERT( rc != SOCKET_ERROR);
-	
-  // create a thread to listen for connections
-  HANDLE thread;
-  {
-    struct THREAD_ARGS args;
-    args.socket_read = socket_read;
-    args.read_count = read_count;
-    DWORD threadID;
-    thread = CreateThread(NULL, 0, socket_READ, &args, 0,&threadID); 
-  
-    ASSERT(thread != NULL);
-  }
-  
-  {
-    int addrlen = sizeof(server);
-    rc = getsockname(socket_read, (struct sockaddr *)&server, &addrlen); ASSERT(!rc);
-    _RPT_D(":socket-read :port-opened %d\n", ntohs(server.sin_port));
-  }
-
-  // connect write socket to read socket 
-  _RPT_D(":socket-write :connecting...\n");
-  rc = connect(socket_write , (struct sockaddr *)&server , sizeof(server));
-  ASSERT(rc != SOCKET_ERROR);
-  
-  HANDLE write_handle = (HANDLE)socket_write;
-  HANDLE child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
-
-  WaitForSingleObject(child, INFINITE );
-  RPT(":child-exited\n");
-  
-  WaitForSingleObject(thread, INFINITE );
-  _RPT_D(":thread-exited\n");         
-  closesocket(socket_read);
-  closesocket(socket_write);	  
-  WSACleanup();
-}
-
-
-bool args_PARSE(int argc, char const * argv[], int args[])
-/* Parse ARGC number of arguments from ARGV, and on success place
-   results in ARGS. First entry of ARGV is program name/path. ARGS
-   must have enough space to accommodate ARGC number of entries.
-
-   The arguments are parsed according to the descriptions in `usage'
-   global variable.
-
-   The first entry in ARGS is the count of arguments succesfully parsed. 
-
-   Each other entry can be
-   1. an e_args command or identifier, or
-   2. an integer number
-
-   It prints out `usage' in case of no arguments provided, or an error
-   with an indicator/description where the parsing has gone wrong.
-
-   It returns true on success, false otherwise.
-*/
-{
-  assert(e_E-e_S == sizeof(usage)/sizeof(char*));
-    
-  memset(args, 0, sizeof(int)*argc);
-  
-  int c = 0;
-  if (argc > 1)
-    {
-      for (int v=1;v<argc;v++)
-	{
-	  args[++c] = strtol(argv[v], NULL, 10);
-	  assert(args[c]>e_I && "negative integer arg overlaps with reserved enum range");
-	  if (args[c] < e_I
-	      || (args[c] == 0 && strcmp("0", argv[v])))
-	    {
-	      enum e_args e = args[c] =
-		!strcmp(":to-stderr"           , argv[v]) ? eTO_STDERR            :
-		!strcmp(":to-child-stderr"     , argv[v]) ? eTO_CHILD_STDERR      :
-		!strcmp(":pipe"                , argv[v]) ? ePIPE                 :
-		!strcmp(":pipe-handle-to-child", argv[v]) ? ePIPE_HANDLE_TO_CHILD :
-		!strcmp(":to-handle"           , argv[v]) ? eTO_HANDLE            :
-		!strcmp(":pipe-to-child-stderr", argv[v]) ? ePIPE_TO_CHILD_STDERR :
-		!strcmp(":sock-to-child-stderr", argv[v]) ? eSOCK_TO_CHILD_STDERR :
-		!strcmp(":write"               , argv[v]) ? eWRITE                :
-		!strcmp(":write-nl"            , argv[v]) ? eWRITE_NL             :
-		!strcmp(":pipe-size"           , argv[v]) ? ePIPE_SIZE            :
-		!strcmp(":read"                , argv[v]) ? eREAD                 :
-		!strcmp(":unbuf"               , argv[v]) ? eUNBUF                :
-		!strcmp(":lnbuf"               , argv[v]) ? eLNBUF                :
-		!strcmp(":flbuf"               , argv[v]) ? eFLBUF                :
-		e_S;
-
-	      if (e==e_S) break;
-	    }
-	};
-    }
-  args[0] = c;
-  
-#define _USAGE() {printf("usage: %s COMMANDS\n\n%s\n\ncommands:\n",argv[0],usage[0]); \
-                  for(int i=1;i<e_E-e_S;i++)printf("  %s\n\n",usage[i]);return false;}
-  if (!args[0]) _USAGE();
-
-  
-  int x = 1;
-#define _OPTIONS(C) {printf("%s",argv[0]);for(int i=1;i<x;i++)printf(" %s",argv[i]);\
-                     printf(" ::error::\n\noptions:\n\t%s\t\n",usage[C-e_S]); return false;}
-  enum e_args cmd = args[x];
-  switch (cmd)
-    {
-    case eTO_STDERR: case eTO_CHILD_STDERR:
-      if (++x > args[0]) _OPTIONS(cmd);
-      switch (args[x])
-	{
-	case eWRITE: case eWRITE_NL:
-	  /* WRITE-COUNT */
-	  if (++x > args[0]) _OPTIONS(cmd);
-	  if (args[x] <= 0) _OPTIONS(cmd);
-	  break;
-	default: _OPTIONS(cmd);
-	}
-      if (x < args[0]) switch(args[++x])
-			 {
-			 case eUNBUF: break;
-			 case eLNBUF: case eFLBUF:
-			   /* BUFFER-SIZE */
-			   if (++x > args[0]) _OPTIONS(cmd);
-			   if (args[x] <= 1) _OPTIONS(cmd);
-			   break;
-			 default: _OPTIONS(cmd);
-			 }
-      break;
-    case ePIPE: case ePIPE_HANDLE_TO_CHILD:
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != ePIPE_SIZE) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-      
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != eREAD) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != eWRITE) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] <= 0) _OPTIONS(cmd);      
-      break;
-    case eTO_HANDLE:
-      /* HANDLE */
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-      /* WRITE-COUNT */
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-      break;
-    case ePIPE_TO_CHILD_STDERR:
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != ePIPE_SIZE) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != eREAD) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-
-      if (++x > args[0]) _OPTIONS(cmd);
-      switch (args[x])
-	{
-	case eWRITE: case eWRITE_NL:
-	  /* WRITE-COUNT */
-	  if (++x > args[0]) _OPTIONS(cmd);
-	  if (args[x] <= 0) _OPTIONS(cmd);
-	  break;
-	default: _OPTIONS(cmd);
-	}
-      if (x < args[0]) switch(args[++x])
-			 {
-			 case eUNBUF: break;
-			 case eLNBUF: case eFLBUF:
-			   /* BUFFER-SIZE */
-			   if (++x > args[0]) _OPTIONS(cmd);
-			   if (args[x] <= 1) _OPTIONS(cmd);
-			   break;
-			 default: _OPTIONS(cmd);
-			 }
-      break;
-    case eSOCK_TO_CHILD_STDERR:
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] != eREAD) _OPTIONS(cmd);
-      if (++x > args[0]) _OPTIONS(cmd);
-      if (args[x] < 0) _OPTIONS(cmd);      
-
-      if (++x > args[0]) _OPTIONS(cmd);
-      switch (args[x])
-	{
-	case eWRITE: case eWRITE_NL:
-	  /* WRITE-COUNT */
-	  if (++x > args[0]) _OPTIONS(cmd);
-	  if (args[x] <= 0) _OPTIONS(cmd);
-	  break;
-	default: _OPTIONS(cmd);
-	}
-      if (x < args[0]) switch(args[++x])
-			 {
-			 case eUNBUF: break;
-			 case eLNBUF: case eFLBUF:
-			   /* BUFFER-SIZE */
-			   if (++x > args[0]) _OPTIONS(cmd);
-			   if (args[x] <= 1) _OPTIONS(cmd);
-			   break;
-			 default: _OPTIONS(cmd);
-			 }
-      break;
-    default: _USAGE();
-    }
-  if (++x<=args[0])_OPTIONS(cmd);
-  
-  if (0) {printf(":args");for(int i=0;i<=c;i++){printf(" %d",args[i]);};printf("\n");};
-  return true;
-    
-}
-
-int strings_JOIN(int aistart, int total, char const * prefix,
-		 char const * argv[], char* buffer, int buffer_size)
-/* Join the strings in ARGV using space as a separator, starting from
-   AISTART index and using PREFIX as the first string. ARGV has TOTAL
-   number of entries.
-
- The resulting string is written in BUFFER of BUFFER-SIZE.
-
- When BUFFER is NULL or BUFFER-SIZE is 0, it returns the size of the
- buffer required to write the result, otherwise it returns
- BUFFER-SIZE.
-*/
-{
-  if (buffer==NULL || buffer_size==0)
-    {
-      int argc = total;
-      char const * subcmd = prefix;
-      int cmdargs_size = 1+strlen(subcmd);
-      for(int i=aistart;i<argc;i++) cmdargs_size+=1+strlen(argv[i]);
-      return cmdargs_size;      
-    }
-  else
-    {
-      int argc = total;
-      char const * subcmd = prefix;
-      char* cmdargs = buffer;
-      int cmdargs_size = buffer_size;
-      
-      memset(cmdargs,0,cmdargs_size);
-      int copied=0;
-      {
-	const int subcmd_size = strlen(subcmd);
-	assert(cmdargs_size>subcmd_size);
-	strncpy(cmdargs, subcmd, subcmd_size);
-	copied+=subcmd_size;
-      }
-      char const * separator = " ";
-      const int sep_len = strlen(separator);
-      for(int i=aistart;i<argc;i++)
-	{
-	  assert(cmdargs_size>copied+sep_len);
-	  strncat(cmdargs,separator, cmdargs_size-copied);
-	  copied+=sep_len;
-	  const int str_size = strlen(argv[i]);
-	  assert(cmdargs_size>copied+str_size);
-	  strncat(cmdargs,argv[i],cmdargs_size-copied);
-	  copied+=str_size;
-	}
-      assert(copied==cmdargs_size-1);
-      return cmdargs_size;
-    }
-}
-
-DWORD _EXIT(LPVOID _exit_ms)
-{
-  DWORD* exit_ms = (DWORD*)_exit_ms;
-  Sleep(*exit_ms);
-  RPT(":killing-after-inactivity-secs %ld\n", *exit_ms/1000);
-  exit(99);
-}
-
-void log_SETUP(int argc, char const* argv[])
-/* Setup global logging variables and print out the ARGC number of
-   command line arguments found in ARGV that were used to start this
-   process.
-
-   When printing something out using this logging facility the file
-   type of standard error will be indicated by the following symbols:
-
-   '*' => char device or console  - `FILE_TYPE_CHAR'
-   '+' => file                    - `FILE_TYPE_DISK'
-   '|' => anonymous or named pipe - `FILE_TYPE_PIPE' but not a socket
-   '&' => socket                  - `FILE_TYPE_PIPE' and is a socket
-   '!' => remote                  - `FILE_TYPE_REMOTE'
-   '?' => unknown
-*/
-{
-  // time before the program exits forcefully. Has to be static since
-  // it is used an arg to the thread
-  static DWORD exit_ms=2000;
-
-  _PID = GetProcessId(GetCurrentProcess());
-  {
-    HANDLE sh=(HANDLE)_get_osfhandle(_fileno(stderr)); assert(sh);
-    DWORD ft=GetFileType(sh);
-    _CM =
-      ft==FILE_TYPE_CHAR   ? '*' :
-      ft==FILE_TYPE_DISK   ? '+' :
-      ft==FILE_TYPE_PIPE   ? '|' :
-      ft==FILE_TYPE_REMOTE ? '!' : '?';
-
-    if (_CM=='|' &&
-	!GetNamedPipeInfo(sh, NULL, NULL, NULL, NULL))
-      _CM = '&';
-  }
-
-  // name of mutex is simply prefix/PID
-  char const * prefix = "pipe-test/";
-  int prefix_len = strlen(prefix);
-  
-  // check if the parent process has passed in the name of the mutex
-  // (thus this process is a child process) or create a new mutex for
-  // sync'ing logging.
-  STARTUPINFO si; memset(&si, 0, sizeof(si));
-  GetStartupInfo(&si);
-  if (si.cbReserved2>prefix_len
-      && !strncmp(prefix, (char*)si.lpReserved2+sizeof(DWORD), strlen(prefix)))
-    {
-      _RL="CHILD";      
-      exit_ms=1000;
-      _MX_ID = calloc(si.cbReserved2, sizeof(char));
-      strncpy(_MX_ID, (char*)si.lpReserved2+sizeof(DWORD), si.cbReserved2);
-      _OUTMX = OpenMutex(MUTEX_ALL_ACCESS, FALSE, _MX_ID); assert(_OUTMX);
-    }
-  else
-    {
-      int id_size = 1;
-      id_size+=snprintf(NULL, 0, "%s%ld", prefix, _PID);
-      _MX_ID = calloc(id_size, sizeof(char));
-      snprintf(_MX_ID, id_size, "%s%ld", prefix, _PID);
-      _OUTMX = CreateMutex(NULL, FALSE, _MX_ID); assert(_OUTMX);
-    }
-
-  
-  {
-    DWORD wr=WaitForSingleObject(_OUTMX, INFINITE); assert(wr==WAIT_OBJECT_0);
-    printf("[CMD%c:%s] ",_CM,_RL);
-    for(int i=1;i<argc;i++){printf("%s ",argv[i]);} printf("\n");
-    fflush(stdout);
-    DWORD ro=ReleaseMutex(_OUTMX); assert(ro);
-  }
-
-  {
-    DWORD threadID;
-    HANDLE thread = CreateThread(NULL, 0, _EXIT, &exit_ms, 0,&threadID);
-    ASSERT(thread != NULL);
-  }
-  
-}
+/* A tool to investigate the buffering behavior of stderr on MS-Windows (and POSIX).
+
+ MIT License
+
+ Copyright (c) 2021 Ioannis Kappas
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE. */
+     
+#ifndef _WIN32
+#define _GNU_SOURCE
+#endif
+#include <assert.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef _WIN32
+#include <io.h>
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stddef.h>
+#include <linux/io_uring.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/futex.h>
+#include <linux/seccomp.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#endif
+
+
+#define _DEBUG_DO 0
+
+/* The Win32 implementation is the reference one. The POSIX backend,
+   selected at build time, mirrors it with fork/exec, pipe2, socketpair
+   and a process-shared mutex. */
+#ifdef _WIN32
+typedef HANDLE child_t;   /* a spawned child process */
+typedef HANDLE fhandle_t; /* an OS file handle a child can inherit */
+#define _NO_FHANDLE NULL
+#define fwrite_unlocked _fwrite_nolock
+#define flockfile _lock_file
+#define funlockfile _unlock_file
+#else
+typedef pid_t child_t;
+typedef int fhandle_t;
+#define _NO_FHANDLE (-1)
+static inline int _read(int fd, void* buf, unsigned int count) { return read(fd, buf, count); }
+static inline int _write(int fd, void const* buf, unsigned int count) { return write(fd, buf, count); }
+static inline int _close(int fd) { return close(fd); }
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define closesocket close
+#endif
+
+enum e_args {
+  e_S=INT_MIN, /* start of commands barrier */
+  eTO_STDERR, eTO_CHILD_STDERR, ePIPE,
+  ePIPE_HANDLE_TO_CHILD, eTO_HANDLE,
+  ePIPE_TO_CHILD_STDERR, eSOCK_TO_CHILD_STDERR, ePTY_TO_CHILD_STDERR,
+  eSHM_TO_CHILD,
+  eBENCH_THROUGHPUT, eSWEEP, eBENCH_SPLICE, eFANIN_CHILDREN,
+  ePROBE_PIPE_CAPACITY, ePROBE_STDIO_BUFFER, eVERIFY_STREAM, eBENCH_SOCKET,
+  eBENCH_SPAWN, eTRACE_TO_JSON,
+  e_E,         /* end of commands barrier */
+  eWRITE, eWRITE_NL,
+  ePIPE_SIZE, eREAD, eLATENCY, eSTAMP, eQUIET, eREPEAT,
+  eTRANSPORT, eVIA_PIPE, eVIA_SOCK, eVIA_PTY, eVIA_SHM, eVIA_INHERIT, eVIA_FILE,
+  eDEFAULT, eJOBS, eCSV, eJSON, eVMSPLICE,
+  eREADER, eREAD_BLOCKING, eREAD_EPOLL, eREAD_URING, eSHM, eTRACE_CHILD,
+  eSTDOUT, eHOLD, eRECORDS,
+  ePRELOAD, ePOLICY_UNBUF, ePOLICY_LNBUF, ePOLICY_BYTES, ePOLICY_US,
+  eUNBUF, eLNBUF, eFLBUF, eADAPTIVE,
+  eRSS, eSPAWNER, eSPAWN_FORK, eSPAWN_VFORK, eSPAWN_POSIX, eSPAWN_CLONE,
+  ePOOL,
+  eSOCKET, eSOCK_PAIR, eSOCK_UNIX, eSOCK_SEQPACKET, eSOCK_TCP,
+  eSNDBUF, eRCVBUF, eNODELAY, eCORK, eZEROCOPY,
+  eREAD_RATE, ePACE, eSTALLS,
+  eSTREAM, eSTREAM_CERR, eSTREAM_CLOG, eSTREAM_FWRITE, eSTREAM_WRITE2,
+  eWRITE_API, eAPI_FPUTC, eAPI_FPUTS, eAPI_FPRINTF, eAPI_FWRITE_UNLOCKED, eAPI_WRITEV,
+  eWRITER_THREADS, eTHREAD_BUFFER,
+  e_I,         /* end of identifiers barrier */
+};
+
+static char const * usage[] =
+  {"A utility to probe stderr's behavior on Windows and Linux. The commands and options marked (Linux) are not available on Windows.\n\n"
+   "options:\n"
+   "  :deadline-ms MS"
+     "\n\tExit a process that makes no progress for MS milliseconds (2000 by default), and a child process after half of that. On Linux the deadline is kept to the sub-millisecond, and the operation the process was blocked in is reported along with the offset it reached in the stream.\n\n"
+   "  :trace FILE"
+     "\n\t(Linux) Have the parent and the child processes record a timeline of their starts, spawns, setvbuf() calls, writes to the stderr stream, write syscalls, reads and exits, with the time they started at and took, in the memory mapped FILE. See :trace-to-json to view it.",
+
+   /* The order of entries below should match the order of commands in `e_args' */
+   ":to-stderr [:quiet] [:shm HANDLE] [:stamp] [:repeat RCOUNT] [:vmsplice] [:stdout] [:hold MS] [:pace BYTES-PER-S] [:stalls HANDLE] ([:writer-threads T RCOUNT [:thread-buffer BYTES]] [(:stream cerr|clog|fwrite|write2)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev CALL-BYTES)]"
+     " :write|:write-nl COUNT [:unbuf|(:lnbuf|:flbuf BUFFER-SIZE)|(:adaptive MAXDELAY-US BUFFER-SIZE)])|(:records RLEN RCOUNT)"
+     "\n\twrite COUNT '$' characters to stderr (:write-nl will also write an \\n at the end). Optionally change stderr's mode to unbuffered (:unbuf),  line (:lnbuf) or fully (:flbuf) buffered using a new buffer of BUFFER-SIZE."
+     "\n\tWith :adaptive (Linux) stderr is replaced by a stream that coalesces the writes in a buffer of BUFFER-SIZE, which a background thread flushes as soon as its oldest byte has waited MAXDELAY-US, and reports the write syscalls issued and the longest delay."
+     "\n\tWith :repeat the characters are written RCOUNT times."
+     "\n\tWith :quiet no commentary is written."
+     "\n\tWith :stamp (helper option to support :latency) the characters are preceded by a monotonic timestamp."
+     "\n\tWith :vmsplice (Linux, helper option to support :bench-splice) the characters are vmsplice()d into stderr, which must be a pipe, bypassing the stream."
+     "\n\tWith :shm (Linux, helper option to support :shm-to-child) the characters are written to the shared memory ring of HANDLE instead of stderr."
+     "\n\tWith :stdout (helper option to support :probe-stdio-buffer) stdout is made a duplicate of stderr and the characters are written to it instead, and with :hold the process waits MS milliseconds before exiting."
+     "\n\tWith :pace (helper option to support :bench-throughput) the characters are written no faster than BYTES-PER-S, and with :stalls (Linux, ditto) the time of each write is recorded in the shared memory file of HANDLE."
+     "\n\tWith :stream the characters are written with std::cerr (cerr) or std::clog (clog) instead of fwrite() to stderr (fwrite, the default), or with a _write() syscall each to stderr's handle (write2), which takes no buffering mode. "
+     "The iostreams are left in sync with stdio when no buffering mode is given, for their writes to go through stderr, or else sync_with_stdio(false) is called and they are given an unbuffered (:unbuf) or fully buffered (:flbuf) buffer of their own with pubsetbuf(); "
+     "std::cerr is still flushed after each write."
+     "\n\tWith :write-api the characters of each write are put out instead in calls of CALL-BYTES to fputc() (one character a call, CALL-BYTES must be 1), fputs(), fprintf(\"%.*s\"), fwrite(), fwrite_unlocked() (with the "
+     "stream locked once for all of them), _write() (write2) or, on Linux, gathered 64 at a time into a writev() (writev), and the average time of a call and the write syscalls issued per KB are reported, even with :quiet."
+     "\n\tWith :writer-threads (Linux) T threads write the characters RCOUNT times each to stderr at the same time, each with a character of its own in place of the '$'s, with fwrite() "
+     "(the default) or with _write() (write2); the throughput and the number of fwrite()s that found stderr locked by another thread, with the time they waited for it, are reported."
+     "\n\tWith :thread-buffer the threads collect their writes in a buffer of BYTES of their own instead, which goes out with a single fwrite_unlocked() under the stream's lock when full."
+     "\n\tWith :records (helper option to support :verify-stream) RCOUNT numbered and checksummed records of RLEN bytes are written to stderr's handle instead.",
+   ":to-child-stderr [:trace-child] [:writer-threads T RCOUNT [:thread-buffer BYTES]] [(:stream cerr|clog|fwrite|write2)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev CALL-BYTES)]"
+     " :write|:write-nl COUNT [:unbuf|(:lnbuf|:flbuf BUFFER-SIZE)|(:adaptive MAXDELAY-US BUFFER-SIZE)] [:preload unbuf|lnbuf|(bytes N)|(us T) RUNS MBYTES]"
+     "\n\tCreate a child process and have it write to its stderr stream. Takes same options as :to-stderr."
+     "\n\tWith :preload (Linux, and not with :stream) the child's stderr is redirected to a _pipe() instead, and the latency of RUNS records (see :pipe-to-child-stderr) and the throughput of MBYTES (see :bench-throughput) are measured first as is and then with "
+     "the stest-preload.so shim preloaded into the child, which overrides the buffering the child sets with unbuffered (unbuf), line buffered (lnbuf), fully buffered with a buffer of N bytes (bytes) or fully buffered and flushed every T microseconds (us)."
+     "\n\tWith :trace-child (Linux) the child runs under ptrace() with a seccomp filter that stops it only at its write() and writev() calls to stderr, and the parent "
+     "reports each call with the time since the child was spawned and the bytes requested and written, followed by the number of calls, of bytes and of partial writes.",
+   ":pipe :pipe-size SIZE :read RCOUNT :write WCOUNT"
+     "\n\tCreate a _pipe() of size SIZE, write WCOUNT '$' characters to the pipe's write endpoint and read RCOUNT characters from the pipe's read endpoint.",
+   ":pipe-handle-to-child [:reader blocking|epoll|uring] :pipe-size SIZE :read RCOUNT :write WCOUNT"
+     "\n\tCreate a _pipe() of size SIZE. Also create a child process passing the write pipe's handle as a command line argument to it. The child will open the handle and write WCOUNT '$' characters to it. The parent process will attempt to read RCOUNT characters from the pipe's read's endpoint.",
+   ":to-handle HANDLE WRITE-COUNT"
+     "\n\thelper option to support :pipe-handle-to-child. Attempts to open HANDLE and write WRITE-COUNT '$' characters to it.",
+   ":pipe-to-child-stderr [:pool WORKERS|:trace-child] [:reader blocking|epoll|uring] :pipe-size PSIZE :read RCOUNT|:latency RUNS [:writer-threads T RCOUNT [:thread-buffer BYTES]] [(:stream cerr|clog|fwrite|write2)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev CALL-BYTES)]"
+     " :write|:write-nl WCOUNT [:unbuf|(:lnbuf|:flbuf BSIZE)|(:adaptive MAXDELAY-US BSIZE)]"
+     "\n\tCreate a _pipe() of size PSIZE. Then create a child process with its stderr redirected to the pipe's write endpoint. The parent process will attempt to read RCOUNT characters from the pipe's read endpoint. "
+     "The child process will attempt to write to its stderr (see :to-stderr for information on the stream, write and buffering mode options)."
+     "\n\tWith :latency the experiment is repeated RUNS times, the child timestamps its write and the parent reports the distribution of the delays until the first byte arrived."
+     "\n\tWith :reader (Linux) the parent reads with blocking calls (the default), with non-blocking calls waiting on epoll() or with io_uring multishot reads into a ring of provided buffers."
+     "\n\tWith :pool (Linux) WORKERS child processes are forked once at start up, and each child process is instead a job handed to an idle one over a control channel, along with the handle to use as its stderr, sparing it the cost of spawning and loading the program."
+     "\n\tSee :to-child-stderr for :trace-child."
+     "\n\tWith :writer-threads (Linux, see :to-stderr, not with :latency) the parent reads all the child writes, RCOUNT characters at a time, and reports the throughput, the records that arrived, the runs of a thread's characters that are not whole records, i.e. "
+     "records torn apart by another thread's write, and the times the records of one thread were interleaved with another's.",
+   ":sock-to-child-stderr [:pool WORKERS|:trace-child] [:reader blocking|epoll|uring] :read RCOUNT|:latency RUNS [:writer-threads T RCOUNT [:thread-buffer BYTES]] [(:stream cerr|clog|fwrite|write2)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev CALL-BYTES)]"
+     " :write|:write-nl WCOUNT [:unbuf|(:lnbuf|:flbuf BSIZE)|(:adaptive MAXDELAY-US BSIZE)]"
+     "\n\tCreate a pair of read and write sockets. Then create a child process with its stderr redirected to the write socket. The parent process will attempt to read RCOUNT characters from the read socket. "
+     "The child process will attempt to write to its stderr (see :to-stderr for information on the stream, write and buffering mode options)."
+     "\n\tSee :pipe-to-child-stderr for :latency, :reader, :pool and :writer-threads, and :to-child-stderr for :trace-child.",
+   ":pty-to-child-stderr [:pool WORKERS|:trace-child] [:reader blocking|epoll|uring] :read RCOUNT|:latency RUNS [:writer-threads T RCOUNT [:thread-buffer BYTES]] [(:stream cerr|clog|fwrite|write2)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev CALL-BYTES)]"
+     " :write|:write-nl WCOUNT [:unbuf|(:lnbuf|:flbuf BSIZE)|(:adaptive MAXDELAY-US BSIZE)]"
+     "\n\t(Linux) Create a pseudo terminal. Then create a child process with its stderr redirected to the terminal's slave side. The parent process will attempt to read RCOUNT characters from the master side. Takes the same options as :sock-to-child-stderr.",
+   ":shm-to-child :read RCOUNT|:latency RUNS :write|:write-nl WCOUNT"
+     "\n\t(Linux) Create a single producer, single consumer ring in a shared memory file (memfd) and a child process that writes to the ring instead of its stderr, passing the file's handle to it. "
+     "Writer and reader only make a futex() call to wake each other up when the other side is waiting on an empty or a full ring. The parent process will attempt to read RCOUNT characters from the ring."
+     "\n\tSee :pipe-to-child-stderr for :latency. :bench-throughput takes shm as a transport for throughput comparisons.",
+   ":bench-throughput [:pool WORKERS] [:reader blocking|epoll|uring...] :transport pipe|sock|pty|shm|inherit... MBYTES :write WCOUNT [:read-rate BYTES-PER-S] [:pace BYTES-PER-S] [(:stream cerr|clog|fwrite|write2...)|(:write-api fputc|fputs|fprintf|fwrite|fwrite-unlocked|write2|writev... CALL-BYTES)]"
+     " [:pipe-size PSIZE...] [:unbuf|(:lnbuf|:flbuf BSIZE...)|(:adaptive MAXDELAY-US BSIZE...)]"
+     "\n\tFor each combination of reader (see :pipe-to-child-stderr), transport, stream or write API, PSIZE and BSIZE, create a child process with its stderr redirected to a _pipe() of PSIZE, to a socket, to a pseudo terminal, to a shared memory ring "
+     "(see :shm-to-child, the buffering mode and the reader do not apply) or inherited from the parent, which writes MBYTES of '$' characters in chunks of WCOUNT characters (see :to-stderr for information on the stream, write API and buffering mode "
+     "options, the child reports the cost of each :write-api call). The parent process reads them all and reports the throughput, the bytes per write and read syscall, the syscalls the reader issued per MB and the CPU time of the parent and the child."
+     "\n\tSee :pipe-to-child-stderr for :pool, which does not apply to the shm and inherit transports."
+     "\n\tWith :read-rate the parent reads no faster than BYTES-PER-S, in reads of up to 10ms worth of bytes, and with :pace the child writes no faster than BYTES-PER-S. "
+     "With either (Linux, and not with :pool), the child takes the time of each of its writes, and the distribution of those is reported along with the time they took altogether and its share of the elapsed time, i.e. how long the child was stalled by a slow reader.",
+   ":sweep :transport pipe|sock|pty|inherit... (:write|:write-nl WCOUNT...)... [:read RCOUNT...] [:pipe-size PSIZE...] [:default] [:unbuf] [:lnbuf BSIZE...] [:flbuf BSIZE...] [:jobs N] [:csv|:json]"
+     "\n\tRun the :pipe-to-child-stderr (pipe), :sock-to-child-stderr (sock) or :to-child-stderr (inherit) experiment, or :pty-to-child-stderr (pty), for every combination of the given transports, write counts, read counts (default 1), pipe sizes and buffering modes (:default leaves "
+     "stderr's mode unchanged, which is also the case when no mode is given). Up to N experiments (default the number of cores) run in parallel, each in its own process group with its output captured through its own pipe. The results are written out as CSV (default) or JSON.",
+   ":bench-splice MBYTES :write WCOUNT"
+     "\n\t(Linux) Create a child process with its stderr redirected to a _pipe(), which writes MBYTES of '$' characters in chunks of WCOUNT characters either with fwrite() to unbuffered stderr or with vmsplice(). "
+     "The parent forwards them to a file, to a socket or to both by copying (read() and write()) or without copying (splice() and tee()), and reports the throughput and the CPU time of the parent and the child for each combination.",
+   ":fanin-children N... :transport pipe|sock :repeat RCOUNT :write WCOUNT"
+     "\n\t(Linux) For each N, create N child processes, each with its stderr redirected to its own _pipe() or socket, which write RCOUNT timestamped records of WCOUNT '$' characters. "
+     "The parent drains all of them through a single epoll() event loop, and reports the aggregate throughput and the distribution of the delays until the first byte of each record arrived, as well as the lowest and highest mean delay of any one child.",
+   ":probe-pipe-capacity PSIZE..."
+     "\n\t(Linux) For each PSIZE, create a _pipe() of PSIZE (0 for the kernel's default) and report the capacity granted, the bytes it takes to fill it with non-blocking writes and whether any of those were partial. "
+     "Then have two threads write records of PIPE_BUF and of four times PIPE_BUF bytes to such a pipe at the same time, and report how many records were torn apart by the other thread's writes.",
+   ":probe-stdio-buffer [:transport pipe|sock|pty|file...]"
+     "\n\t(Linux) For each transport (default all), and for each of stdout and stderr, find out how a child process buffers the stream when redirected to a _pipe(), a socket, a pseudo terminal (which stands for a console) or a file, by checking whether its writes arrive before it exits: unbuffered "
+     "when a single character does, line buffered when it does with a new line, and otherwise, as well as for line buffering, the effective buffer size is the smallest write that arrives, as found with a binary search. Reports the mode, the buffer size and how many bytes the first flush brought.",
+   ":verify-stream [:reader blocking|epoll|uring...] :transport pipe|sock|pty|shm... MBYTES :records RLEN"
+     "\n\tFor each combination of reader (see :pipe-to-child-stderr) and transport, create a child process with its stderr redirected to a _pipe(), a socket, a pseudo terminal in raw mode or a shared memory ring (see :shm-to-child), which writes MBYTES of records of RLEN bytes (a multiple of 8, at least 32), "
+     "each with a sequence number and a checksum of its contents, generated in chunks as it goes. The parent checks every record as it arrives and reports the records lost, duplicated, out of order or torn, the bytes skipped to get back in sync, the throughput and the rate of the check alone.",
+   ":bench-socket :socket pair|unix|seqpacket|tcp... RUNS MBYTES :write WCOUNT [:sndbuf BYTES...] [:rcvbuf BYTES...] [:nodelay] [:cork] [:zerocopy]"
+     "\n\t(Linux) For each kind of socket pair, Unix domain stream sockets from socketpair() (pair) or connected through a listening socket (unix), Unix domain sequenced packet sockets from socketpair() (seqpacket) or TCP sockets connected on the loopback interface (tcp), for each size of the child's "
+     "send buffer (:sndbuf) and of the parent's receive buffer (:rcvbuf), the kernel's default unless given, and with each of the options given, TCP_NODELAY (:nodelay, tcp only), TCP_CORK (:cork, tcp only) and SO_ZEROCOPY (:zerocopy, which the child's plain write() calls do not make use of), turned "
+     "off and on on the child's stderr socket, measure the delay of RUNS records of WCOUNT '$' characters (see :pipe-to-child-stderr) and the throughput of MBYTES written in chunks of WCOUNT characters (see :bench-throughput). The buffer sizes granted and the options refused are reported as well.",
+   ":bench-spawn RUNS [:rss MBYTES...] [:spawner fork|vfork|posix-spawn|clone...]"
+     "\n\t(Linux) For each MBYTES (default 0), grow the parent process by MBYTES of touched memory, and for each spawner (default all) create RUNS child processes, each with its stderr redirected to a _pipe() and writing a single '$' to it, with fork() and execve() (fork), vfork() "
+     "and execve() (vfork), posix_spawn() (posix-spawn) or clone() with CLONE_VM|CLONE_VFORK and execve() (clone). Reports the parent's resident size and the distribution of the time until the spawning call returned to the parent and until the child's first byte arrived.",
+   ":trace-to-json"
+     "\n\tRead a :trace FILE from stdin and write it to stdout in the Chrome trace event format, for a timeline viewer such as Perfetto or chrome://tracing. "
+     "Each process is a track of its spawns, writes, write syscalls and reads, along with a counter of the bytes written to its stderr stream but not yet written out by a syscall, i.e. those sitting in the stream's buffer."
+  };
+
+/* helper macros to assist with safe e_args indexing */
+#define _CMD_INFO(C) usage[(C)-e_S]
+#define _IDN_ASRT(C) assert((C)>e_E&&(C)<e_I);
+
+/* variables and utility macros to assist with synchronizing logging
+   output (to stdout) between parent and child by using a named mutex
+   whose ID (i.e. name) is passed over to the child. */
+#ifdef _WIN32
+static DWORD _PID=-1;static char _CM=' ';static HANDLE _OUTMX=NULL;static char* _MX_ID=NULL;
+#define _MX_LOCK() {DWORD wr=WaitForSingleObject(_OUTMX, INFINITE); assert(wr==WAIT_OBJECT_0);}
+#define _MX_UNLOCK() {DWORD ro=ReleaseMutex(_OUTMX); assert(ro);}
+#else
+/* a robust mutex in a named shared memory object, so that a process
+   killed while holding it does not starve the others. */
+static pid_t _PID=-1;static char _CM=' ';static pthread_mutex_t* _OUTMX=NULL;static char* _MX_ID=NULL;
+#define _MX_LOCK() {int wr=pthread_mutex_lock(_OUTMX);                       \
+                    if (wr==EOWNERDEAD) wr=pthread_mutex_consistent(_OUTMX); \
+                    assert(wr==0);}
+#define _MX_UNLOCK() {int ro=pthread_mutex_unlock(_OUTMX); assert(ro==0);}
+
+/* With STEST_RING_LOG set in the environment, the commentary lines are
+   not printed as they happen but recorded, lock free, in a ring of
+   events per process, all in the shared memory object that holds the
+   mutex. The parent prints the events of all processes sorted by time
+   when it exits. */
+#define _LOG_RINGS 64
+#define _LOG_EVENTS 2048  /* per ring */
+#define _LOG_TEXT 240
+struct LOG_EVENT {
+  uint64_t ns;          /* monotonic time it was recorded at */
+  uint32_t committed;   /* set once the event is complete */
+  char cm; bool cmd;    /* stderr's file type, and whether a CMD line */
+  char rl[6];
+  char text[_LOG_TEXT];
+};
+struct LOG_RING {
+  uint32_t next;        /* index of the next free event */
+  uint32_t dropped;     /* events not recorded for lack of space */
+  struct LOG_EVENT events[_LOG_EVENTS];
+};
+struct LOG_SHM {
+  pthread_mutex_t mx;
+  uint32_t rings_used;
+  struct LOG_RING rings[_LOG_RINGS];
+};
+static struct LOG_SHM* _LOG_SHM=NULL;static struct LOG_RING* _RING=NULL;
+bool log_RECORD(bool cmd, char const * fs, ...) __attribute__((format(printf, 2, 3)));
+void log_DUMP(void);
+#define _RPT_RING(...) (_RING && log_RECORD(false, __VA_ARGS__))
+#define _LOG_DUMP() log_DUMP()
+#endif
+#ifndef _RPT_RING
+#define _RPT_RING(...) false
+#define _LOG_DUMP()
+#endif
+static char const * _RL="PARNT";
+#define RPT(FS, ...) {if (!_RPT_RING(FS __VA_OPT__(,) __VA_ARGS__)) {              \
+		      _MX_LOCK();                                                   \
+		      printf("[RPT%c:%s] " FS,_CM,_RL  __VA_OPT__(,) __VA_ARGS__); \
+		      fflush(stdout);					             \
+		      _MX_UNLOCK();}}
+#define _RPT_D(...) if (_DEBUG_DO) RPT(__VA_ARGS__)
+
+/* when set, the process writes no commentary of its own, i.e. when it
+   is one of many children spawned for a measurement. */
+static bool _QUIET=false;
+
+/* when set, the children are spawned under ptrace() and their writes
+   to stderr are reported (see `trace_SPAWN'). */
+static bool _TRACE_CHILD=false;
+
+/* when set, the :to-stderr children with a redirected stderr are not
+   spawned but handed to the workers of a pool forked at start up (see
+   `pool_OPEN'). */
+#ifndef _WIN32
+struct POOL_WORKER;
+static struct POOL_WORKER* _POOL=NULL;static int _POOL_SIZE=0;
+#endif
+
+/* the kind of socket pairs `socket_PAIR' creates and the options it
+   sets on them, as varied by :bench-socket (POSIX). */
+struct SOCK_OPTS {
+  enum e_args kind;      /* `eSOCK_PAIR', `eSOCK_UNIX', `eSOCK_SEQPACKET' or `eSOCK_TCP' */
+  int sndbuf, rcvbuf;    /* the sizes of the buffers, the default when 0 */
+  bool nodelay, cork, zerocopy;
+};
+#ifndef _WIN32
+static struct SOCK_OPTS _SOCK={eSOCK_PAIR, 0, 0, false, false, false};
+#endif
+
+/* the monotonic time in ns of the last progress of long running
+   experiments, taken to keep the inactivity watchdog (see `_EXIT') at
+   bay. */
+static uint64_t _ACTIVITY=0;
+/* time in us before the program exits forcefully when inactive,
+   halved for child processes so that they exit before their parent,
+   see `log_SETUP'. The watchdog is handed its address. */
+static int _EXIT_US=2000000;
+#define _KICK() __atomic_store_n(&_ACTIVITY, clock_NS(), __ATOMIC_RELAXED)
+
+/* the operation the process is about to block in, i.e. reading from or
+   writing to FD at OFFSET bytes into the stream, for the watchdog to
+   watch the readiness of FD and report it if the process is stuck in
+   it. Both _BLOCKING and _PROGRESS, which moves OFFSET on, are
+   `_KICK'ed activity, stamped before the OFFSET the watchdog checks
+   first. A switch to another FD wakes the watchdog through `_WAKE_FD',
+   for it to watch FD from the start of the operation on. */
+struct BLOCKING {
+  char const * op;
+  int fd;
+  bool writing;
+  long long offset;
+};
+static struct BLOCKING _BLOCKED={NULL, -1, false, 0};
+static int _WAKE_FD=-1;
+#define _BLOCKING(OP, FD, WRITING, OFFSET) {				\
+    _KICK();								\
+    __atomic_store_n(&_BLOCKED.op, (OP), __ATOMIC_RELAXED);		\
+    __atomic_store_n(&_BLOCKED.writing, (WRITING), __ATOMIC_RELAXED);	\
+    __atomic_store_n(&_BLOCKED.offset, (OFFSET), __ATOMIC_RELEASE);	\
+    if (__atomic_exchange_n(&_BLOCKED.fd, (FD), __ATOMIC_RELEASE) != (FD)) \
+      watchdog_WAKE(); }
+#define _PROGRESS(OFFSET) {						\
+    _KICK();								\
+    __atomic_store_n(&_BLOCKED.offset, (OFFSET), __ATOMIC_RELEASE); }
+
+static void watchdog_WAKE(void)
+/* Have the watchdog look at `_BLOCKED' again, see `_EXIT'. */
+{
+#ifndef _WIN32
+  int wake = __atomic_load_n(&_WAKE_FD, __ATOMIC_RELAXED);
+  if (wake != -1) eventfd_write(wake, 1);
+#endif
+}
+
+/* the kinds of events of a :trace timeline */
+enum e_events {
+  eEV_START=1, /* 0 marks an event claimed but not written yet */
+  eEV_SPAWN, eEV_SETVBUF, eEV_WRITE, eEV_FLUSH, eEV_READ, eEV_EXIT
+};
+/* an event of a :trace timeline, see `timeline_ADD' */
+struct TIMELINE_EVENT {
+  uint64_t ns, dur;  /* the monotonic time it started at and took */
+  int64_t bytes;     /* written or read, the child's pid for `eEV_SPAWN'
+			and the buffer size for `eEV_SETVBUF' */
+  int32_t pid;
+  int16_t fd;
+  uint8_t kind;      /* `e_events' */
+  char aux;          /* the mode of `eEV_SETVBUF' ('n', 'l' or 'f') and
+			the role of `eEV_START' ('P' or 'C') */
+};
+/* a :trace file shared by all processes of a run, the header followed
+   by the events in the order they were claimed */
+#define _TIMELINE_MAGIC "STESTTL1"
+#define _TIMELINE_EVENTS (1<<20)
+struct TIMELINE {
+  char magic[8];
+  uint64_t capacity;
+  uint64_t claimed;  /* past capacity when events were dropped */
+  struct TIMELINE_EVENT events[];
+};
+static struct TIMELINE* _TIMELINE=NULL;
+
+/* logging version of assert */
+#define ASSERT(COND) {bool cond=COND;     \
+    if (!cond) {RPT(":ASSERTION-FAILED"   \
+                    " %s :FILE %s, :LINE %d\n", #COND, __FILE__, __LINE__); \
+                _LOG_DUMP(); abort(); }}
+
+bool args_PARSE(int argc, char const * argv[], int args[]);
+void log_SETUP(int argc, char const* argv[]);
+#ifndef _WIN32
+void mx_UNLINK(void);
+#endif
+int strings_JOIN(int aistart, int total, char const * prefix,
+		 char const * argv[], char* buffer, int buffer_size);
+child_t child_SPAWN(char const * cmdargs, fhandle_t err_handle);
+void child_WAIT(child_t child);
+int pipe_OPEN(int pfds[2], int pipe_size);
+fhandle_t fd_INHERITABLE(int fd);
+void handle_CLOSE(fhandle_t handle);
+int to_stderr(int const args[], char** stream_buffer);
+void pipe_test(int pipe_size, int write_count, int read_count);
+/* a parent side reading engine, see `reader_OPEN' */
+struct READER {
+  enum e_args kind;   /* `eREAD_BLOCKING', `eREAD_EPOLL' or `eREAD_URING' */
+  intptr_t handle; bool sock;
+  long long syscalls; /* issued so far to read */
+  long long bytes;    /* read so far */
+#ifndef _WIN32
+  int epfd;
+  struct URING* uring;
+#endif
+};
+void reader_OPEN(struct READER* reader, enum e_args kind, intptr_t handle, bool sock);
+int reader_READ(struct READER* reader, char* buffer, int size);
+void reader_CLOSE(struct READER* reader);
+char const * reader_NAME(enum e_args kind);
+void pipe_handle_to_child(int pipe_size, int write_count, int read_count,
+			  enum e_args reader);
+void pipe_to_child_stderr(int pipe_size, int read_count, char const * cmdargs,
+			  enum e_args reader);
+void socket_to_child_stderr(int read_count, char const * cmdargs, enum e_args reader);
+int pty_OPEN(int fds[2]);
+struct SHM_RING;
+struct SHM_RING* shm_OPEN(int* fd);
+struct SHM_RING* shm_MAP(int fd);
+int shm_READ(struct SHM_RING* ring, char* buffer, int size);
+int shm_WRITE(struct SHM_RING* ring, char const * buffer, int size);
+void shm_CLOSE(struct SHM_RING* ring, bool writer);
+child_t shm_SPAWN(char const * cmdargs, struct SHM_RING** ring);
+void shm_to_child(int read_count, char const * cmdargs);
+void pty_to_child_stderr(int read_count, char const * cmdargs, enum e_args reader);
+/* A histogram of ns values with logarithmic buckets, each power of 2
+   range split into linear sub-buckets (in the spirit of HdrHistogram),
+   for a relative precision of ~6%. */
+#define _HIST_SUB_BITS 4
+#define _HIST_SUB (1<<_HIST_SUB_BITS)
+struct HISTOGRAM {
+  uint64_t counts[(64-_HIST_SUB_BITS+1)*_HIST_SUB];
+  uint64_t total, min, max;
+};
+void hist_ADD(struct HISTOGRAM* hist, uint64_t ns);
+/* the time a child spent in each of its writes, kept in a shared
+   memory file for the parent to report, see :read-rate */
+struct STALLS {
+  struct HISTOGRAM hist;
+  uint64_t blocked_ns;  /* the sum of them */
+};
+struct STALLS* stalls_OPEN(int* fd);
+struct STALLS* stalls_MAP(int fd);
+void stalls_CLOSE(struct STALLS* stalls);
+uint64_t hist_PERCENTILE(struct HISTOGRAM const * hist, double percent);
+void hist_RPT(struct HISTOGRAM const * hist, char const * name);
+void latency_to_child_stderr(enum e_args via, int pipe_size, int runs, int record_len,
+			     char const * cmdargs, enum e_args reader);
+uint64_t clock_NS(void);
+uint64_t cpu_NS(void);
+int pipe_CAPACITY(int fd);
+void throughput_BENCH(enum e_args via, int mbytes, int write_count,
+		      int pipe_size, enum e_args mode, int max_delay_us,
+		      int buffer_size, enum e_args reader, int read_rate, int pace,
+		      enum e_args stream, int call_bytes);
+bool sweep_RUN(int const args[], int args_count);
+void splice_BENCH(int mbytes, int write_count, bool vmsplice, enum e_args forward,
+		  bool to_file, bool to_sock);
+void fanin_BENCH(enum e_args via, int children, int repeat, int write_count);
+void pipe_PROBE(int pipe_size);
+void stdio_PROBE(enum e_args via, bool to_stdout);
+void records_WRITE(struct SHM_RING* ring, int record_len, long long count);
+void stream_VERIFY(enum e_args via, int mbytes, int record_len, enum e_args reader);
+void preload_BENCH(enum e_args policy, int policy_value, int runs, int mbytes,
+		   enum e_args write_type, int write_count, enum e_args mode, int buffer_size);
+void spawn_BENCH(enum e_args spawner, int runs, int rss_mbytes);
+void pool_OPEN(int workers);
+void socket_BENCH(struct SOCK_OPTS const * opts, int runs, int mbytes, int write_count);
+void timeline_OPEN(char const * path, bool create);
+void timeline_ADD(enum e_events kind, uint64_t ns, uint64_t dur, int fd, long long bytes,
+		  char aux);
+FILE* timeline_STREAM(FILE* like);
+void timeline_JSON(void);
+
+/* resources a child process used, as collected by `child_REAP' */
+struct CHILD_STATS {
+  uint64_t cpu_ns;         /* user and kernel CPU time */
+  int64_t write_syscalls;  /* write syscalls issued, -1 when unknown */
+};
+void child_REAP(child_t child, struct CHILD_STATS* stats);
+#ifndef _WIN32
+child_t pool_SPAWN(char const * cmdargs, fhandle_t err_handle);
+bool pool_WAIT(child_t child, struct CHILD_STATS* stats);
+#endif
+void stamp_SET(char* msg);
+void pace_WAIT(uint64_t start, long long done, int rate);
+void stalls_ADD(struct STALLS* stalls, uint64_t ns);
+FILE* adaptive_OPEN(int max_delay_us, int buffer_size);
+char const * stream_NAME(enum e_args kind);
+bool stream_MODE_OK(enum e_args kind, enum e_args mode);
+bool api_OK(enum e_args api, int call_bytes);
+bool writer_PARSE(int const args[], int* at, bool latency,
+		  int* threads, int* thread_buffer, enum e_args* stream);
+int writer_SKIP(int const args[], int at, int* threads);
+long long api_WRITE(enum e_args api, FILE* stream, int fd, char* msg, int msg_len,
+		    int call_bytes);
+int64_t api_SYSCALLS(void);
+long long threads_WRITE(FILE* stream, int fd, int threads, int thread_buffer,
+			char const * msg, int msg_len, int repeat, char const * mode_name);
+void threads_to_child_stderr(enum e_args via, int pipe_size, int read_count, int letters,
+			     char const * cmdargs, enum e_args reader);
+/* the C++ iostreams of :stream cerr|clog, see stderr-stream.cpp */
+void iostream_OPEN(bool clog, bool synced, char* buffer, int buffer_size);
+size_t iostream_WRITE(char const * msg, size_t len);
+void iostream_FLUSH(void);
+
+/* length of the timestamp `stamp_SET' writes, '@' followed by the
+   zero padded decimal monotonic time in ns */
+#define _STAMP_LEN 21
+
+/* how the commentary of a process the watchdog stops starts, followed
+   by "secs" (Win32) or "ms" (POSIX) and the inactivity, see `_EXIT' */
+#define _KILLED ":killing-after-inactivity-"
+
+/* the shortest record of a verified stream, see `records_WRITE' */
+#define _RECORD_MIN 32
+
+/* the chars the :writer-threads fill their records with, one each */
+#define _WRITER_MARKS "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+#define _WRITER_THREADS_MAX ((int)sizeof(_WRITER_MARKS)-1)
+
+
+
+int main(int argc, char const * argv[])
+{
+  // options of all commands, handed down to the child processes
+  // through the environment, see `log_SETUP' and `timeline_OPEN'
+  bool trace = false;
+  while (argc > 2 && (!strcmp(argv[1], ":deadline-ms") || !strcmp(argv[1], ":trace")))
+    {
+      char const * var = !strcmp(argv[1], ":trace") ? "STEST_TRACE" : "STEST_DEADLINE_MS";
+#ifdef _WIN32
+      _putenv_s(var, argv[2]);
+#else
+      setenv(var, argv[2], 1);
+#endif
+      trace = trace || !strcmp(argv[1], ":trace");
+      argv[2] = argv[0]; argv += 2; argc -= 2;
+    }
+  int args[argc];
+  if (!args_PARSE(argc, argv, args)) return 1;
+  ASSERT(args[0] == argc-1);
+
+  _QUIET = (args[1]==eTO_STDERR && args[2]==eQUIET) || args[1]==eSWEEP
+    || args[1]==eTRACE_TO_JSON;
+  log_SETUP(argc,argv);
+  // the child processes map the file their parent created
+  if (getenv("STEST_TRACE")) timeline_OPEN(getenv("STEST_TRACE"), trace);
+  
+  int ailast=-1; /* the index of the last argument considered */
+  const int argslen = args[++ailast];
+  
+  switch(args[++ailast])
+    {
+    case eTO_STDERR:
+      return to_stderr(args, NULL);
+    case eTO_CHILD_STDERR:
+      {
+	if (args[ailast+1]==eTRACE_CHILD) { ++ailast; _TRACE_CHILD = true; }
+	ASSERT( ailast+1 < argc );
+	int preload = ailast+1;
+	while (preload < argc && args[preload] != ePRELOAD) preload++;
+	if (preload < argc)
+	  {
+	    enum e_args write_type = args[ailast+1];
+	    int write_count = args[ailast+2];
+	    enum e_args mode = preload > ailast+3 ? args[ailast+3] : 0;
+	    int buffer_size = preload > ailast+4 ? args[ailast+4] : 0;
+	    enum e_args policy = args[preload+1];
+	    int value_at = preload+2 + (policy==ePOLICY_BYTES || policy==ePOLICY_US);
+	    preload_BENCH(policy, args[preload+2], args[value_at], args[value_at+1],
+			  write_type, write_count, mode, buffer_size);
+	    return 0;
+	  }
+	char subcmd[] = ":to-stderr";
+	int cmdargs_size = strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
+	char cmdargs[cmdargs_size];
+	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
+      
+	child_t child = child_SPAWN(cmdargs, _NO_FHANDLE);
+
+	child_WAIT( child );
+	RPT(":child-exited\n");
+
+	return 0;
+      }
+    case ePIPE:
+      {
+	ASSERT( args[++ailast] == ePIPE_SIZE );
+	int pipe_size = args[++ailast];
+	ASSERT( args[++ailast] == eREAD );
+	int read_count = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+      
+	ASSERT( ailast == argslen );
+	
+	pipe_test(pipe_size, write_count, read_count);
+	return 0; 
+      }
+    case ePIPE_HANDLE_TO_CHILD:
+      {
+	enum e_args reader = eREAD_BLOCKING;
+	if (args[ailast+1]==eREADER) { ++ailast; reader = args[++ailast]; }
+	ASSERT( args[++ailast] == ePIPE_SIZE );
+	int pipe_size = args[++ailast];
+	ASSERT( args[++ailast] == eREAD );
+	int read_count = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+      
+	ASSERT( ailast == argslen );
+      
+	pipe_handle_to_child(pipe_size, write_count, read_count, reader);
+	return 0;
+      }
+    case eTO_HANDLE:
+      {
+	int arg_handle = args[++ailast];
+	int write_count = args[++ailast];
+
+	ASSERT( ailast == argslen );
+	
+
+	fhandle_t handle = (fhandle_t)(intptr_t) arg_handle;
+
+	char* msg = calloc(write_count+1, sizeof(char)); ASSERT(msg);
+	memset(msg, '$', sizeof(char)*write_count);
+
+	RPT(":writing-bytes %d\n", write_count);
+#ifdef _WIN32
+	DWORD wrote;
+	int retval = WriteFile(handle, msg, write_count, &wrote, NULL);
+	ASSERT( retval != 0 );
+#else
+	_BLOCKING("write", handle, true, 0);
+	int wrote = write(handle, msg, write_count);
+	ASSERT( wrote != -1 );
+#endif
+	RPT(":wrote-bytes %d\n", (int)wrote);
+	free(msg);
+
+	RPT(":exiting...\n");
+
+	return 0;
+      }
+    case ePIPE_TO_CHILD_STDERR:
+      {
+	if (args[ailast+1]==ePOOL) { ++ailast; pool_OPEN(args[++ailast]); }
+	if (args[ailast+1]==eTRACE_CHILD) { ++ailast; _TRACE_CHILD = true; }
+	enum e_args reader = eREAD_BLOCKING;
+	if (args[ailast+1]==eREADER) { ++ailast; reader = args[++ailast]; }
+	ASSERT( args[++ailast] == ePIPE_SIZE );
+	int pipe_size = args[++ailast];
+	enum e_args read_mode = args[++ailast];
+	ASSERT( read_mode == eREAD || read_mode == eLATENCY );
+	int read_count = args[++ailast];
+
+	int threads;
+	int w = writer_SKIP(args, ailast, &threads);
+	ASSERT( w+2 < argc );
+	int record_len = _STAMP_LEN + args[w+2] + (args[w+1]==eWRITE_NL);
+	
+	char const * subcmd = read_mode==eLATENCY ? ":to-stderr :quiet :stamp" : ":to-stderr";
+	int cmdargs_size=strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
+	char cmdargs[cmdargs_size];
+	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
+      
+	if (threads)
+	  threads_to_child_stderr(eVIA_PIPE, pipe_size, read_count, args[w+2], cmdargs,
+				  reader);
+	else if (read_mode == eLATENCY)
+	  latency_to_child_stderr(eVIA_PIPE, pipe_size, read_count, record_len, cmdargs,
+				  reader);
+	else
+	  pipe_to_child_stderr(pipe_size, read_count, cmdargs, reader);
+	return 0;
+      }
+    case eSOCK_TO_CHILD_STDERR: case ePTY_TO_CHILD_STDERR:
+      {
+	enum e_args cmd = args[ailast];
+	if (args[ailast+1]==ePOOL) { ++ailast; pool_OPEN(args[++ailast]); }
+	if (args[ailast+1]==eTRACE_CHILD) { ++ailast; _TRACE_CHILD = true; }
+	enum e_args reader = eREAD_BLOCKING;
+	if (args[ailast+1]==eREADER) { ++ailast; reader = args[++ailast]; }
+	enum e_args read_mode = args[++ailast];
+	ASSERT( read_mode == eREAD || read_mode == eLATENCY );
+	int read_count = args[++ailast];
+
+	int threads;
+	int w = writer_SKIP(args, ailast, &threads);
+	ASSERT( w+2 < argc );
+	int record_len = _STAMP_LEN + args[w+2] + (args[w+1]==eWRITE_NL);
+	
+	char const * subcmd = read_mode==eLATENCY ? ":to-stderr :quiet :stamp" : ":to-stderr";
+	int cmdargs_size=strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
+	char cmdargs[cmdargs_size];
+	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
+      
+	if (threads)
+	  threads_to_child_stderr(cmd==ePTY_TO_CHILD_STDERR ? eVIA_PTY : eVIA_SOCK,
+				  0, read_count, args[w+2], cmdargs, reader);
+	else if (read_mode == eLATENCY)
+	  latency_to_child_stderr(cmd==ePTY_TO_CHILD_STDERR ? eVIA_PTY : eVIA_SOCK,
+				  0, read_count, record_len, cmdargs, reader);
+	else if (cmd == ePTY_TO_CHILD_STDERR)
+	  pty_to_child_stderr(read_count, cmdargs, reader);
+	else
+	  socket_to_child_stderr(read_count, cmdargs, reader);
+	return 0;
+      }
+    case eSHM_TO_CHILD:
+      {
+	enum e_args read_mode = args[++ailast];
+	ASSERT( read_mode == eREAD || read_mode == eLATENCY );
+	int read_count = args[++ailast];
+
+	ASSERT( ailast+2 < argc );
+	int record_len = _STAMP_LEN + args[ailast+2] + (args[ailast+1]==eWRITE_NL);
+
+	char const * subcmd = read_mode==eLATENCY ? ":to-stderr :quiet :stamp" : ":to-stderr";
+	int cmdargs_size=strings_JOIN(++ailast, argc, subcmd, argv, NULL, 0);
+	char cmdargs[cmdargs_size];
+	strings_JOIN(ailast, argc, subcmd, argv, cmdargs, cmdargs_size);
+
+	if (read_mode == eLATENCY)
+	  latency_to_child_stderr(eVIA_SHM, 0, read_count, record_len, cmdargs,
+				  eREAD_BLOCKING);
+	else
+	  shm_to_child(read_count, cmdargs);
+	return 0;
+      }
+    case eBENCH_THROUGHPUT:
+      {
+	if (args[ailast+1]==ePOOL) { ++ailast; pool_OPEN(args[++ailast]); }
+	int const default_reader = eREAD_BLOCKING;
+	int const * readers = &default_reader; int readers_count = 1;
+	if (args[ailast+1]==eREADER)
+	  {
+	    ++ailast; readers = &args[ailast+1]; readers_count = 0;
+	    while (args[ailast+1]!=eTRANSPORT) { ++ailast; ++readers_count; }
+	  }
+	ASSERT( args[++ailast] == eTRANSPORT );
+	int const * vias = &args[ailast+1]; int vias_count = 0;
+	while (ailast<argslen && args[ailast+1]<0) { ++ailast; ++vias_count; }
+	int mbytes = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+	int read_rate = 0, pace = 0;
+	if (ailast<argslen && args[ailast+1]==eREAD_RATE) { ++ailast; read_rate = args[++ailast]; }
+	if (ailast<argslen && args[ailast+1]==ePACE) { ++ailast; pace = args[++ailast]; }
+	// fwrite() when no stream is given
+	int const default_stream = 0;
+	int const * streams = &default_stream; int streams_count = 1;
+	if (ailast<argslen && args[ailast+1]==eSTREAM)
+	  {
+	    ++ailast; streams = &args[ailast+1]; streams_count = 0;
+	    while (ailast<argslen && args[ailast+1]>=eSTREAM_CERR
+		   && args[ailast+1]<=eSTREAM_WRITE2) { ++ailast; ++streams_count; }
+	  }
+	int call_bytes = 0;
+	if (ailast<argslen && args[ailast+1]==eWRITE_API)
+	  {
+	    ++ailast; streams = &args[ailast+1]; streams_count = 0;
+	    while (args[ailast+1]<0) { ++ailast; ++streams_count; }
+	    call_bytes = args[++ailast];
+	  }
+
+	// the kernel's default when no pipe size is given
+	int const default_psize = 0;
+	int const * psizes = &default_psize; int psizes_count = 1;
+	if (ailast<argslen && args[ailast+1]==ePIPE_SIZE)
+	  {
+	    ++ailast; psizes = &args[ailast+1]; psizes_count = 0;
+	    while (ailast<argslen && args[ailast+1]>0) { ++ailast; ++psizes_count; }
+	  }
+
+	enum e_args mode = 0; int max_delay_us = 0;
+	int const default_bsize = 0;
+	int const * bsizes = &default_bsize; int bsizes_count = 1;
+	if (ailast<argslen)
+	  {
+	    mode = args[++ailast]; _IDN_ASRT(mode);
+	    if (mode == eADAPTIVE) max_delay_us = args[++ailast];
+	    if (mode != eUNBUF)
+	      {
+		bsizes = &args[ailast+1]; bsizes_count = 0;
+		while (ailast<argslen && args[ailast+1]>0) { ++ailast; ++bsizes_count; }
+	      }
+	  }
+
+	ASSERT( ailast == argslen );
+
+	for (int r=0;r<readers_count;r++)
+	  for (int v=0;v<vias_count;v++)
+	    for (int p=0;p<(vias[v]==eVIA_PIPE ? psizes_count : 1);p++)
+	      // the shared memory ring is no stream, takes no buffering
+	      // mode and is read by none of the readers
+	      for (int k=0;k<(vias[v]==eVIA_SHM ? (r ? 0 : 1) : streams_count);k++)
+		for (int b=0;b<(vias[v]==eVIA_SHM ? 1 : bsizes_count);b++)
+		  throughput_BENCH(vias[v], mbytes, write_count,
+				   vias[v]==eVIA_PIPE ? psizes[p] : 0, mode, max_delay_us,
+				   bsizes[b], readers[r], read_rate, pace, streams[k],
+				   call_bytes);
+	return 0;
+      }
+    case eSWEEP:
+      return sweep_RUN(&args[ailast+1], argslen-ailast) ? 0 : 1;
+    case eBENCH_SPLICE:
+      {
+	int mbytes = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+
+	ASSERT( ailast == argslen );
+
+	enum e_args const forwards[] = { eREAD, eBENCH_SPLICE };
+	for (int w=0;w<2;w++)
+	  for (int f=0;f<2;f++)
+	    {
+	      splice_BENCH(mbytes, write_count, w, forwards[f], true, false);
+	      splice_BENCH(mbytes, write_count, w, forwards[f], false, true);
+	      splice_BENCH(mbytes, write_count, w, forwards[f], true, true);
+	    }
+	return 0;
+      }
+    case eFANIN_CHILDREN:
+      {
+	int const * ns = &args[ailast+1]; int ns_count = 0;
+	while (args[ailast+1] > 0) { ++ailast; ++ns_count; }
+	ASSERT( args[++ailast] == eTRANSPORT );
+	enum e_args via = args[++ailast];
+	ASSERT( args[++ailast] == eREPEAT );
+	int repeat = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+
+	ASSERT( ailast == argslen );
+
+	for (int n=0;n<ns_count;n++)
+	  fanin_BENCH(via, ns[n], repeat, write_count);
+	return 0;
+      }
+    case ePROBE_PIPE_CAPACITY:
+      {
+	while (ailast<argslen) pipe_PROBE(args[++ailast]);
+	return 0;
+      }
+    case eVERIFY_STREAM:
+      {
+	int const default_reader = eREAD_BLOCKING;
+	int const * readers = &default_reader; int readers_count = 1;
+	if (args[ailast+1]==eREADER)
+	  {
+	    ++ailast; readers = &args[ailast+1]; readers_count = 0;
+	    while (args[ailast+1]!=eTRANSPORT) { ++ailast; ++readers_count; }
+	  }
+	ASSERT( args[++ailast] == eTRANSPORT );
+	int const * vias = &args[ailast+1]; int vias_count = 0;
+	while (args[ailast+1]<0) { ++ailast; ++vias_count; }
+	int mbytes = args[++ailast];
+	ASSERT( args[++ailast] == eRECORDS );
+	int record_len = args[++ailast];
+
+	ASSERT( ailast == argslen );
+
+	for (int r=0;r<readers_count;r++)
+	  for (int v=0;v<vias_count;v++)
+	    stream_VERIFY(vias[v], mbytes, record_len, readers[r]);
+	return 0;
+      }
+    case eBENCH_SOCKET:
+      {
+	ASSERT( args[++ailast] == eSOCKET );
+	int const * kinds = &args[ailast+1]; int kinds_count = 0;
+	while (args[ailast+1] >= eSOCK_PAIR && args[ailast+1] <= eSOCK_TCP)
+	  { ++ailast; ++kinds_count; }
+	int runs = args[++ailast];
+	int mbytes = args[++ailast];
+	ASSERT( args[++ailast] == eWRITE );
+	int write_count = args[++ailast];
+
+	// the kernel's default when no size is given
+	int const default_size = 0;
+	int const * sizes[2] = { &default_size, &default_size }; int sizes_count[2] = { 1, 1 };
+	for (int b=0;b<2;b++)
+	  if (ailast<argslen && args[ailast+1]==(b ? eRCVBUF : eSNDBUF))
+	    {
+	      ++ailast; sizes[b] = &args[ailast+1]; sizes_count[b] = 0;
+	      while (ailast<argslen && args[ailast+1]>0) { ++ailast; ++sizes_count[b]; }
+	    }
+	// a bit of each option given, to turn off and on
+	int flags = 0;
+	for (int f=0;f<3;f++)
+	  if (ailast<argslen && args[ailast+1]==eNODELAY+f) { ++ailast; flags |= 1<<f; }
+
+	ASSERT( ailast == argslen );
+
+	for (int k=0;k<kinds_count;k++)
+	  for (int s=0;s<sizes_count[0];s++)
+	    for (int r=0;r<sizes_count[1];r++)
+	      for (int on=0;on<8;on++)
+		{
+		  // TCP_NODELAY and TCP_CORK are for TCP sockets only
+		  if ((on & ~flags) || (kinds[k] != eSOCK_TCP && (on & 3))) continue;
+		  struct SOCK_OPTS opts = { kinds[k], sizes[0][s], sizes[1][r],
+					    on & 1, on & 2, on & 4 };
+		  socket_BENCH(&opts, runs, mbytes, write_count);
+		}
+	return 0;
+      }
+    case eBENCH_SPAWN:
+      {
+	int runs = args[++ailast];
+	int const default_rss = 0;
+	int const * rsses = &default_rss; int rsses_count = 1;
+	if (ailast<argslen && args[ailast+1]==eRSS)
+	  {
+	    ++ailast; rsses = &args[ailast+1]; rsses_count = 0;
+	    while (ailast<argslen && args[ailast+1]>=0) { ++ailast; ++rsses_count; }
+	  }
+	int const all[] = { eSPAWN_FORK, eSPAWN_VFORK, eSPAWN_POSIX, eSPAWN_CLONE };
+	int const * spawners = all; int spawners_count = sizeof(all)/sizeof(all[0]);
+	if (ailast<argslen)
+	  {
+	    ASSERT( args[++ailast] == eSPAWNER );
+	    spawners = &args[ailast+1]; spawners_count = argslen-ailast;
+	  }
+	for (int m=0;m<rsses_count;m++)
+	  for (int s=0;s<spawners_count;s++)
+	    spawn_BENCH(spawners[s], runs, rsses[m]);
+	return 0;
+      }
+    case eTRACE_TO_JSON:
+      ASSERT( ailast == argslen );
+      timeline_JSON();
+      return 0;
+    case ePROBE_STDIO_BUFFER:
+      {
+	int const all[] = { eVIA_PIPE, eVIA_SOCK, eVIA_PTY, eVIA_FILE };
+	int const * vias = all; int vias_count = sizeof(all)/sizeof(all[0]);
+	if (ailast<argslen)
+	  {
+	    ASSERT( args[++ailast] == eTRANSPORT );
+	    vias = &args[ailast+1]; vias_count = argslen-ailast;
+	  }
+	for (int v=0;v<vias_count;v++)
+	  for (int s=0;s<2;s++)
+	    stdio_PROBE(vias[v], s);
+	return 0;
+      }
+    default:
+      ASSERT(0);
+    }
+
+  return 0;
+
+}
+
+int to_stderr(int const args[], char** stream_buffer)
+/* Carry out the :to-stderr command parsed in ARGS (see `args_PARSE').
+   The buffer stderr is given, if any, is placed in STREAM-BUFFER when
+   set, for the caller to free once done with the stream.
+
+   Return the exit code of the command.
+*/
+{
+  int ailast=1; /* the index of the last argument considered */
+  const int argslen = args[0];
+  ASSERT( args[ailast] == eTO_STDERR );
+
+  if (args[ailast+1]==eQUIET) ++ailast;
+  struct SHM_RING* ring = NULL;
+  if (args[ailast+1]==eSHM)
+    {
+      ++ailast;
+      ring = shm_MAP(args[++ailast]); ASSERT(ring);
+    }
+  bool stamp = args[ailast+1]==eSTAMP;
+  if (stamp) ++ailast;
+  int repeat = 1;
+  if (args[ailast+1]==eREPEAT) { ++ailast; repeat = args[++ailast]; }
+  bool spliced = args[ailast+1]==eVMSPLICE;
+  if (spliced) ++ailast;
+  bool to_stdout = args[ailast+1]==eSTDOUT;
+  if (to_stdout) ++ailast;
+  int hold_ms = 0;
+  if (args[ailast+1]==eHOLD) { ++ailast; hold_ms = args[++ailast]; }
+  int pace = 0;
+  if (args[ailast+1]==ePACE) { ++ailast; pace = args[++ailast]; }
+  struct STALLS* stalls = NULL;
+  if (args[ailast+1]==eSTALLS)
+    {
+      ++ailast;
+      stalls = stalls_MAP(args[++ailast]); ASSERT(stalls);
+    }
+  int threads = 0, thread_buffer = 0;
+  if (args[ailast+1]==eWRITER_THREADS)
+    {
+      ASSERT( repeat == 1 );
+      ++ailast; threads = args[++ailast]; repeat = args[++ailast];
+      if (args[ailast+1]==eTHREAD_BUFFER) { ++ailast; thread_buffer = args[++ailast]; }
+    }
+  enum e_args kind = eSTREAM_FWRITE;
+  if (args[ailast+1]==eSTREAM) { ++ailast; kind = args[++ailast]; }
+  int call_bytes = 0;
+  if (args[ailast+1]==eWRITE_API)
+    {
+      ++ailast; kind = args[++ailast]; call_bytes = args[++ailast];
+    }
+  // the pages of a vmsplice()d message must stay unchanged
+  ASSERT( !(spliced && stamp) );
+  ASSERT( kind == eSTREAM_FWRITE || (!ring && !spliced && !to_stdout) );
+  ASSERT( !call_bytes || (!ring && !spliced) );
+  ASSERT( !threads || (!ring && !spliced && !stamp && !call_bytes && !pace && !stalls
+		       && (kind == eSTREAM_FWRITE || kind == eSTREAM_WRITE2)) );
+  enum e_args msg_type = args[++ailast]; _IDN_ASRT(msg_type);
+  switch(msg_type) { case eWRITE: case eWRITE_NL: case eRECORDS: break; default: ASSERT(0); };
+  if (msg_type == eRECORDS)
+    {
+      int record_len = args[++ailast];
+      int records = args[++ailast];
+      ASSERT( ailast == argslen );
+      if (!_QUIET) RPT(":writing-records %d :record-bytes %d\n", records, record_len);
+      records_WRITE(ring, record_len, records);
+      if (ring) shm_CLOSE(ring, true);
+      if (!_QUIET) RPT(":exiting...\n");
+      return 0;
+    }
+
+  int write_count = args[++ailast];
+
+  enum e_args mode=0; int buffer_size=1; int max_delay_us=0;
+  if (ailast<argslen)
+    {
+      mode=args[++ailast]; _IDN_ASRT(mode);
+      switch (mode)
+	{
+	case eADAPTIVE:
+	  ASSERT(ailast<argslen); max_delay_us=args[++ailast];
+	  // fall through
+	case eLNBUF: case eFLBUF:
+	  ASSERT(ailast<argslen); buffer_size=args[++ailast]; break;
+	case eUNBUF: break;
+	default: ASSERT(0);
+	}
+    }
+
+  ASSERT( ailast == argslen );
+
+  // must be created on the heap since it might be still used
+  // past this block when the program is exited and stderr is
+  // flushed.
+  char* buffer = calloc(buffer_size+1, sizeof(char)); 
+  if (stream_buffer) *stream_buffer = buffer;
+  FILE* stream = stderr;
+  if (to_stdout)
+    {
+      // before stdout's first use, which settles its buffering
+      ASSERT( dup2(STDERR_FILENO, STDOUT_FILENO) != -1 );
+      stream = stdout;
+    }
+  int fd = fileno(stream);
+  FILE* adaptive = NULL;
+  ASSERT( stream_MODE_OK(kind, mode) );
+  if (kind == eSTREAM_CERR || kind == eSTREAM_CLOG)
+    iostream_OPEN(kind == eSTREAM_CLOG, !mode, buffer, mode == eFLBUF ? buffer_size : 0);
+  else if (kind == eSTREAM_WRITE2 || kind == eAPI_WRITEV)
+    ; // straight to the handle, there is no stream
+  else if (mode == eADAPTIVE)
+    {
+      adaptive = adaptive_OPEN(max_delay_us, buffer_size);
+      if (adaptive) stream = adaptive;
+    }
+  else
+    {
+      if (_TIMELINE) stream = timeline_STREAM(stream);
+      if (mode)
+	{
+	  int ret = setvbuf(stream, buffer,
+			    mode==eUNBUF ? _IONBF :
+			    mode==eLNBUF ? _IOLBF :
+			    _IOFBF,
+			    buffer_size);
+	  ASSERT( !ret );
+	  timeline_ADD(eEV_SETVBUF, clock_NS(), 0, fd, mode==eUNBUF ? 0 : buffer_size,
+		       mode==eUNBUF ? 'n' : mode==eLNBUF ? 'l' : 'f');
+	}
+    }
+
+  int msg_len=write_count;
+  if (msg_type==eWRITE_NL) ++msg_len;
+  if (stamp) msg_len+=_STAMP_LEN;
+  // too large for the stack when benchmarking, and with room for the
+  // '\0' of :write-api fputs
+  char* msg = calloc(msg_len+1, sizeof(char)); ASSERT(msg);
+  memset(msg, '$', msg_len);
+  if (msg_type==eWRITE_NL) msg[msg_len-1] = '\n';
+
+  char const * mode_name = mode==eUNBUF ? "unbuf" : mode==eLNBUF ? "lnbuf"
+    : mode==eFLBUF ? "flbuf" : mode==eADAPTIVE ? "adaptive" : "default";
+  if (!_QUIET) RPT(":writing-bytes %lld\n", (long long)msg_len*repeat*(threads ? threads : 1));
+  long long wrote = 0;
+  if (threads)
+    {
+      wrote = threads_WRITE(stream, kind == eSTREAM_WRITE2 ? fd : -1, threads, thread_buffer,
+			    msg, msg_len, repeat, mode_name);
+    }
+  // the watchdog's wake-up is no write of the experiment
+  if (!spliced && !ring && !threads) _BLOCKING("fwrite", STDERR_FILENO, true, 0);
+  int64_t syscalls = call_bytes ? api_SYSCALLS() : 0;
+  uint64_t start = clock_NS();
+  for (int i=0;i<repeat && !spliced && !ring && !threads;i++)
+    {
+      if (pace) pace_WAIT(start, wrote, pace);
+      if (stamp) stamp_SET(msg);
+      uint64_t before = stalls || _TIMELINE ? clock_NS() : 0;
+      size_t put = 0;
+      if (call_bytes)
+	put = api_WRITE(kind, stream, fd, msg, msg_len, call_bytes);
+      else switch (kind)
+	{
+	case eSTREAM_CERR: case eSTREAM_CLOG:
+	  put = iostream_WRITE(msg, msg_len);
+	  break;
+	case eSTREAM_WRITE2:
+	  while (put < (size_t)msg_len)
+	    {
+	      int moved = _write(fd, msg+put, msg_len-put);
+	      if (moved <= 0) break;
+	      put += moved;
+	    }
+	  break;
+	default:
+	  put = fwrite(msg, sizeof(char), msg_len, stream);
+	}
+      wrote += put;
+      if (stalls) stalls_ADD(stalls, clock_NS()-before);
+      // the writes of the iostreams go out unseen
+      if (_TIMELINE && kind != eSTREAM_CERR && kind != eSTREAM_CLOG)
+	timeline_ADD(kind == eSTREAM_WRITE2 || kind == eAPI_WRITEV ? eEV_FLUSH : eEV_WRITE,
+		     before, clock_NS()-before, fd, put, 0);
+      _PROGRESS(wrote);
+    }
+  if (call_bytes)
+    {
+      // what is left in the buffer goes out with the calls
+      if (kind != eSTREAM_WRITE2 && kind != eAPI_WRITEV) fflush(stream);
+      uint64_t elapsed = clock_NS()-start;
+      long long calls = (long long)repeat
+	* (kind == eAPI_FPUTC ? msg_len : (msg_len+call_bytes-1)/call_bytes);
+      if (syscalls >= 0) syscalls = api_SYSCALLS() - syscalls;
+      RPT(":write-api %s :call-bytes %d :mode %s :calls %lld :ns-per-call %.1f"
+	  " :syscalls-per-kb %.2f\n",
+	  stream_NAME(kind), call_bytes, mode_name, calls, (double)elapsed/calls,
+	  syscalls >= 0 && wrote ? syscalls/(wrote/1024.0) : -1.0);
+    }
+  if (adaptive) fclose(adaptive);
+  if (ring) _BLOCKING("shm-write", -1, true, 0);
+  for (int i=0;i<repeat && ring;i++)
+    {
+      if (pace) pace_WAIT(start, wrote, pace);
+      if (stamp) stamp_SET(msg);
+      uint64_t before = stalls ? clock_NS() : 0;
+      int put = shm_WRITE(ring, msg, msg_len);
+      if (stalls) stalls_ADD(stalls, clock_NS()-before);
+      if (put == -1) break;
+      wrote += put;
+      _PROGRESS(wrote);
+    }
+  if (ring) shm_CLOSE(ring, true);
+#ifdef _WIN32
+  ASSERT( !spliced );
+#else
+  if (spliced) _BLOCKING("vmsplice", STDERR_FILENO, true, 0);
+  for (int i=0;i<repeat && spliced;i++)
+    {
+      struct iovec iov = { msg, msg_len };
+      while (iov.iov_len)
+	{
+	  uint64_t before = _TIMELINE ? clock_NS() : 0;
+	  ssize_t moved = vmsplice(STDERR_FILENO, &iov, 1, 0);
+	  ASSERT( moved > 0 );
+	  if (_TIMELINE) timeline_ADD(eEV_FLUSH, before, clock_NS()-before, STDERR_FILENO, moved, 0);
+	  iov.iov_base = (char*)iov.iov_base + moved; iov.iov_len -= moved;
+	  wrote += moved;
+	  _PROGRESS(wrote);
+	}
+    }
+#endif
+  if (!_QUIET) RPT(":wrote-bytes %lld\n", wrote);
+
+  if (hold_ms)
+    {
+#ifdef _WIN32
+      Sleep(hold_ms);
+#else
+      struct timespec ts = { hold_ms/1000, (hold_ms%1000)*1000000L };
+      while (nanosleep(&ts, &ts) == -1 && errno == EINTR) continue;
+#endif
+    }
+
+  if (!_QUIET) RPT(":exiting...\n");
+
+  return 0;
+}
+
+#ifdef _WIN32
+child_t child_SPAWN(char const * cmdargs, fhandle_t err_handle)
+/* Spawn a new instance of the program with command line arguments
+   CMDARGS. Optionally redirect the new program's stderr to ERR_HANDLE
+   when set.
+   
+   Return the handle of the new process.
+*/
+{
+  STARTUPINFO start;
+  PROCESS_INFORMATION pi;
+
+  memset (&start, 0, sizeof (start));
+  start.cb = sizeof (start);
+  start.dwFlags = SW_HIDE;
+
+  if (_TRACE_CHILD) RPT(":trace-child :unsupported-on-this-platform\n");
+
+  /* A hack to pass the ID (i.e. name) of the logging
+     synchronization mutex to the child using the Reserved2 field.
+       
+     See "Pass arbitrary data to a child process!" in
+     http://www.catch22.net/tuts/undocumented-createprocess
+  */
+  int id_size = sizeof(DWORD)+strlen(_MX_ID)+1;
+  char buf[id_size]; memset(buf, 0, id_size);
+  strncpy(sizeof(DWORD)+buf, _MX_ID, id_size);
+  start.cbReserved2 = sizeof(buf);
+  start.lpReserved2 = (LPBYTE)buf;
+    
+  if (err_handle != _NO_FHANDLE)
+    {
+      start.dwFlags |= STARTF_USESTDHANDLES;
+      start.hStdInput = GetStdHandle (STD_INPUT_HANDLE);
+      start.hStdOutput = GetStdHandle (STD_OUTPUT_HANDLE);
+
+      start.hStdError = err_handle;
+    }
+
+  TCHAR cmd[MAX_PATH];
+  GetModuleFileName(NULL, cmd, MAX_PATH);
+  int cmdline_size = 1;
+  cmdline_size+=snprintf(NULL, 0, "%s %s", cmd, cmdargs);
+  char* cmdline = malloc(cmdline_size); ASSERT(cmdline);
+  snprintf(cmdline, cmdline_size, "%s %s", cmd, cmdargs);
+  _RPT_D(":parent/child-cmd %s\n", cmdline);
+  
+  int rc = CreateProcessA (NULL, cmdline, NULL, NULL, TRUE /* inherit handles? */,
+			   0,
+			   NULL, NULL, &start, &pi);
+  ASSERT( rc != 0 );
+  free(cmdline);
+
+  return pi.hProcess;
+}
+
+void child_WAIT(child_t child)
+/* Wait for the CHILD process to exit. */
+{
+  WaitForSingleObject(child, INFINITE);
+}
+
+int pipe_OPEN(int pfds[2], int pipe_size)
+/* Create a _pipe() of PIPE-SIZE whose endpoints are not inherited by
+   child processes. Return 0 on success.
+*/
+{
+  return _pipe (pfds, pipe_size, _O_NOINHERIT | _O_BINARY);
+}
+
+fhandle_t fd_INHERITABLE(int fd)
+/* Return an inheritable duplicate of FD's handle. FD is closed.
+*/
+{
+  HANDLE handle;
+  HANDLE parent = GetCurrentProcess ();
+  int retval = DuplicateHandle (parent,
+				(HANDLE) _get_osfhandle (fd),
+				parent,
+				&handle,
+				0,
+				TRUE,
+				DUPLICATE_SAME_ACCESS);
+  ASSERT( retval != 0 );
+  _close(fd);
+  return handle;
+}
+
+void handle_CLOSE(fhandle_t handle)
+/* Close HANDLE, as returned by `fd_INHERITABLE'. */
+{
+  CloseHandle(handle);
+}
+
+static uint64_t filetime_NS(FILETIME ft)
+{
+  return (((uint64_t)ft.dwHighDateTime<<32) | ft.dwLowDateTime) * 100;
+}
+
+void child_REAP(child_t child, struct CHILD_STATS* stats)
+/* Wait for the CHILD process to exit, keeping the watchdog at bay,
+   and fill in STATS with the resources it used. */
+{
+  while (WaitForSingleObject(child, 1) == WAIT_TIMEOUT) _KICK();
+
+  IO_COUNTERS io;
+  stats->write_syscalls = GetProcessIoCounters(child, &io) ? (int64_t)io.WriteOperationCount : -1;
+  FILETIME created, exited, kernel, user;
+  int rc = GetProcessTimes(child, &created, &exited, &kernel, &user); ASSERT(rc);
+  stats->cpu_ns = filetime_NS(kernel) + filetime_NS(user);
+}
+
+uint64_t cpu_NS(void)
+/* Return the CPU time used by this process so far in ns. */
+{
+  FILETIME created, exited, kernel, user;
+  int rc = GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user); ASSERT(rc);
+  return filetime_NS(kernel) + filetime_NS(user);
+}
+
+int pty_OPEN(int fds[2])
+/* Not supported, a pseudo console can not be read through a CRT file
+   descriptor. */
+{
+  (void) fds;
+  RPT(":pty :unsupported-on-this-platform\n");
+  return -1;
+}
+
+struct SHM_RING* shm_OPEN(int* fd)
+/* Not supported. */
+{
+  (void) fd;
+  RPT(":shm :unsupported-on-this-platform\n");
+  return NULL;
+}
+
+struct SHM_RING* shm_MAP(int fd)
+/* Not supported. */
+{
+  (void) fd;
+  return NULL;
+}
+
+struct STALLS* stalls_OPEN(int* fd)
+/* Not supported. */
+{
+  (void) fd;
+  RPT(":stalls :unsupported-on-this-platform\n");
+  return NULL;
+}
+
+struct STALLS* stalls_MAP(int fd)
+/* Not supported. */
+{
+  (void) fd;
+  return NULL;
+}
+
+void stalls_CLOSE(struct STALLS* stalls)
+{
+  (void) stalls;
+}
+
+int shm_READ(struct SHM_RING* ring, char* buffer, int size)
+{
+  (void) ring; (void) buffer; (void) size;
+  return -1;
+}
+
+int shm_WRITE(struct SHM_RING* ring, char const * buffer, int size)
+{
+  (void) ring; (void) buffer; (void) size;
+  return -1;
+}
+
+void shm_CLOSE(struct SHM_RING* ring, bool writer)
+{
+  (void) ring; (void) writer;
+}
+
+int pipe_CAPACITY(int fd)
+/* Return the size of the buffer of the pipe whose read endpoint is FD. */
+{
+  DWORD in_size = 0;
+  GetNamedPipeInfo((HANDLE) _get_osfhandle (fd), NULL, NULL, &in_size, NULL);
+  return in_size;
+}
+#else
+/* a write() or writev() call to stderr a traced child made, see
+   `trace_SPAWN' */
+struct TRACE_EVENT {
+  uint64_t ns;          /* when the call was made */
+  pid_t tid;
+  bool writev;
+  bool pending;         /* not returned yet */
+  long long requested;  /* bytes */
+  long long returned;   /* bytes written, or -errno */
+};
+/* the thread tracing a child */
+struct TRACER {
+  pthread_t thread;
+  char const * cmd; char** cargv; char** cenvp; fhandle_t err_handle;
+  pid_t pid; sem_t spawned;
+  uint64_t start_ns;
+  struct TRACE_EVENT* events; int events_count, events_size;
+  struct TRACER* next;
+};
+static struct TRACER* _TRACERS=NULL;
+
+static void trace_ENTERED(struct TRACER* tr, pid_t tid, uint64_t ns)
+/* Record the write the TID thread of the traced child is stopped
+   at. */
+{
+  struct __ptrace_syscall_info info;
+  if (ptrace(PTRACE_GET_SYSCALL_INFO, tid, sizeof(info), &info) <= 0
+      || info.op != PTRACE_SYSCALL_INFO_SECCOMP) return;
+
+  struct TRACE_EVENT ev = { ns, tid, info.seccomp.nr == __NR_writev, true,
+			    (long long)info.seccomp.args[2], 0 };
+  if (ev.writev)
+    {
+      // add up the lengths of the iovecs, read from the child
+      ev.requested = 0;
+      struct iovec iovs[64];
+      for (uint64_t i=0;i<info.seccomp.args[2];i+=64)
+	{
+	  uint64_t n = info.seccomp.args[2]-i < 64 ? info.seccomp.args[2]-i : 64;
+	  struct iovec local = { iovs, n*sizeof(struct iovec) };
+	  struct iovec remote = { (struct iovec*)info.seccomp.args[1]+i, n*sizeof(struct iovec) };
+	  if (process_vm_readv(tid, &local, 1, &remote, 1, 0) != (ssize_t)local.iov_len) break;
+	  for (uint64_t v=0;v<n;v++) ev.requested += iovs[v].iov_len;
+	}
+    }
+  if (tr->events_count == tr->events_size)
+    {
+      tr->events_size = tr->events_size ? 2*tr->events_size : 1024;
+      tr->events = realloc(tr->events, tr->events_size*sizeof(*tr->events));
+      ASSERT(tr->events);
+    }
+  tr->events[tr->events_count++] = ev;
+}
+
+static void trace_RETURNED(struct TRACER* tr, pid_t tid)
+/* Record what the write the TID thread of the traced child has just
+   returned from returned. */
+{
+  struct __ptrace_syscall_info info;
+  if (ptrace(PTRACE_GET_SYSCALL_INFO, tid, sizeof(info), &info) <= 0
+      || info.op != PTRACE_SYSCALL_INFO_EXIT) return;
+  for (int e=tr->events_count-1;e>=0;e--)
+    if (tr->events[e].tid == tid && tr->events[e].pending)
+      {
+	tr->events[e].returned = info.exit.rval;
+	tr->events[e].pending = false;
+	break;
+      }
+}
+
+// the architecture the syscall numbers of the seccomp filter are of
+#if defined(__x86_64__)
+#define _AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(__aarch64__)
+#define _AUDIT_ARCH AUDIT_ARCH_AARCH64
+#elif defined(__i386__)
+#define _AUDIT_ARCH AUDIT_ARCH_I386
+#else
+#error "no audit architecture for the seccomp filter of :trace-child"
+#endif
+
+static void* trace_RUN(void* arg)
+/* Spawn the child of the TRACER in ARG and trace it until it exits. */
+{
+  struct TRACER* tr = arg;
+
+  // stop at write() and writev() calls to stderr only, whose numbers
+  // are other calls altogether in another architecture's numbering,
+  // e.g. of an i386 binary the child may exec
+  struct sock_filter filter[] = {
+    BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, arch)),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, _AUDIT_ARCH, 0, 6),
+    BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, nr)),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, __NR_write, 1, 0),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, __NR_writev, 0, 3),
+    BPF_STMT(BPF_LD|BPF_W|BPF_ABS, offsetof(struct seccomp_data, args[0])),
+    BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, STDERR_FILENO, 0, 1),
+    BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_TRACE),
+    BPF_STMT(BPF_RET|BPF_K, SECCOMP_RET_ALLOW),
+  };
+  struct sock_fprog prog = { sizeof(filter)/sizeof(filter[0]), filter };
+
+  pid_t pid = fork();
+  if (pid == 0)
+    {
+      // only async-signal-safe calls past this point
+      if (tr->err_handle != _NO_FHANDLE) dup2(tr->err_handle, STDERR_FILENO);
+      if (ptrace(PTRACE_TRACEME, 0, NULL, NULL) == -1
+	  || prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1
+	  || syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &prog) == -1)
+	_exit(126);
+      execve(tr->cmd, tr->cargv, tr->cenvp);
+      _exit(127);
+    }
+  tr->pid = pid;
+  tr->start_ns = clock_NS();
+  sem_post(&tr->spawned);
+  if (pid == -1) return NULL;
+
+  // the child stops at the exec
+  int status;
+  if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) return NULL;
+  ptrace(PTRACE_SETOPTIONS, pid, NULL,
+	 PTRACE_O_TRACESECCOMP | PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE
+	 | PTRACE_O_EXITKILL);
+  ptrace(PTRACE_CONT, pid, NULL, NULL);
+
+  for (;;)
+    {
+      /* Peek first, the exit of the child is left for `child_WAIT' to
+	 collect. The commands that trace have one child at a time, any
+	 other child is a thread of it. */
+      siginfo_t si; memset(&si, 0, sizeof(si));
+      if (waitid(P_ALL, 0, &si, WEXITED | WSTOPPED | WNOWAIT | __WALL) == -1)
+	{
+	  if (errno == EINTR) continue;
+	  break;
+	}
+      if (si.si_pid == pid && si.si_code != CLD_TRAPPED && si.si_code != CLD_STOPPED)
+	break;
+      pid_t tid = waitpid(si.si_pid, &status, __WALL);
+      uint64_t now = clock_NS();
+      // a thread of the child exited
+      if (tid <= 0 || !WIFSTOPPED(status)) continue;
+
+      int sig = 0;
+      if (status>>8 == (SIGTRAP | PTRACE_EVENT_SECCOMP<<8))
+	{
+	  trace_ENTERED(tr, tid, now);
+	  // stop again when it returns
+	  ptrace(PTRACE_SYSCALL, tid, NULL, NULL);
+	  continue;
+	}
+      else if (WSTOPSIG(status) == (SIGTRAP|0x80))
+	trace_RETURNED(tr, tid);
+      else if (status>>16 == 0 && WSTOPSIG(status) != SIGSTOP)
+	// pass on the signals, but for the stops of new threads
+	sig = WSTOPSIG(status);
+      ptrace(PTRACE_CONT, tid, NULL, (void*)(intptr_t)sig);
+    }
+  return NULL;
+}
+
+static pid_t trace_SPAWN(char const * cmd, char* cargv[], char* cenvp[],
+			 fhandle_t err_handle)
+/* Like `child_SPAWN', execute CMD with CARGV and CENVP and the
+   optional ERR-HANDLE as its stderr, but under ptrace() from a thread
+   of its own with a seccomp filter that stops it at each write() and
+   writev() to stderr only. The calls are recorded and reported when
+   the child is waited for (see `trace_JOIN').
+
+   Return the pid of the new process.
+*/
+{
+  struct TRACER* tr = calloc(1, sizeof(*tr)); ASSERT(tr);
+  tr->cmd = cmd; tr->cargv = cargv; tr->cenvp = cenvp; tr->err_handle = err_handle;
+  ASSERT( !sem_init(&tr->spawned, 0, 0) );
+  ASSERT( !pthread_create(&tr->thread, NULL, trace_RUN, tr) );
+  while (sem_wait(&tr->spawned) == -1 && errno == EINTR) continue;
+  sem_destroy(&tr->spawned);
+  ASSERT( tr->pid != -1 );
+  tr->next = _TRACERS; _TRACERS = tr;
+  return tr->pid;
+}
+
+static void trace_JOIN(pid_t child)
+/* Wait for the tracer of CHILD, if it is traced, to finish and report
+   the writes to stderr the child made: the time since it was spawned,
+   the thread, the call and the bytes requested and returned of each,
+   followed by the number of calls, of bytes written and of partial
+   writes.
+*/
+{
+  struct TRACER** at = &_TRACERS;
+  while (*at && (*at)->pid != child) at = &(*at)->next;
+  struct TRACER* tr = *at;
+  if (!tr) return;
+  *at = tr->next;
+  pthread_join(tr->thread, NULL);
+
+  long long bytes = 0; int partial = 0;
+  for (int e=0;e<tr->events_count;e++)
+    {
+      struct TRACE_EVENT const * ev = &tr->events[e];
+      RPT(":trace-write :at-us %.3f :tid %d :%s :requested %lld :returned %lld\n",
+	  (ev->ns-tr->start_ns)/1e3, (int)ev->tid, ev->writev ? "writev" : "write",
+	  ev->requested, ev->returned);
+      if (ev->returned > 0) bytes += ev->returned;
+      partial += ev->returned >= 0 && ev->returned < ev->requested;
+    }
+  RPT(":trace-child :pid %d :write-syscalls %d :bytes %lld :partial-writes %d\n",
+      (int)child, tr->events_count, bytes, partial);
+  free(tr->events);
+  free(tr);
+}
+
+child_t child_SPAWN(char const * cmdargs, fhandle_t err_handle)
+/* Spawn a new instance of the program with command line arguments
+   CMDARGS. Optionally redirect the new program's stderr to ERR_HANDLE
+   when set.
+
+   The ID (i.e. name) of the logging synchronization mutex is passed
+   to the child in the STEST_MX_ID environment variable.
+
+   With a :pool, a :to-stderr command with ERR-HANDLE set is handed to
+   a pool worker instead (see `pool_SPAWN').
+   
+   Return the pid of the new process.
+*/
+{
+  uint64_t start = _TIMELINE ? clock_NS() : 0;
+  if (_POOL_SIZE && err_handle != _NO_FHANDLE && !_TRACE_CHILD)
+    {
+      pid_t pid = pool_SPAWN(cmdargs, err_handle);
+      timeline_ADD(eEV_SPAWN, start, clock_NS()-start, err_handle, pid, 'p');
+      return pid;
+    }
+
+  char cmd[PATH_MAX];
+  ssize_t cmd_len = readlink("/proc/self/exe", cmd, sizeof(cmd)-1);
+  ASSERT( cmd_len > 0 );
+  cmd[cmd_len] = 0;
+  int cmdline_size = 1;
+  cmdline_size+=snprintf(NULL, 0, "%s %s", cmd, cmdargs);
+  // on the heap, there is no limit to the length of CMDARGS
+  char* cmdline = malloc(cmdline_size); ASSERT(cmdline);
+  snprintf(cmdline, cmdline_size, "%s %s", cmd, cmdargs);
+  _RPT_D(":parent/child-cmd %s\n", cmdline);
+
+  // there are no quoted arguments, split at the spaces
+  char** cargv = calloc(cmdline_size, sizeof(char*)); ASSERT(cargv); int cargc = 0;
+  for (char* tok=strtok(cmdline, " "); tok; tok=strtok(NULL, " "))
+    cargv[cargc++] = tok;
+  cargv[cargc] = NULL;
+
+  // the child's environment is ours, with the mutex ID replaced
+  char const * id_var = "STEST_MX_ID=";
+  int envc = 0; while (environ[envc]) envc++;
+  char* cenvp[envc+2]; int cenvc = 0;
+  for (int i=0;i<envc;i++)
+    if (strncmp(environ[i], id_var, strlen(id_var))) cenvp[cenvc++] = environ[i];
+  int id_size = 1+snprintf(NULL, 0, "%s%s", id_var, _MX_ID);
+  char id[id_size];
+  snprintf(id, id_size, "%s%s", id_var, _MX_ID);
+  cenvp[cenvc++] = id;
+  cenvp[cenvc] = NULL;
+
+  pid_t pid = -1;
+  if (_TRACE_CHILD) pid = trace_SPAWN(cmd, cargv, cenvp, err_handle);
+  else
+    {
+      pid = fork();
+      ASSERT( pid != -1 );
+      if (pid == 0)
+	{
+	  // only async-signal-safe calls past this point
+	  if (err_handle != _NO_FHANDLE) dup2(err_handle, STDERR_FILENO);
+	  execve(cmd, cargv, cenvp);
+	  _exit(127);
+	}
+    }
+  timeline_ADD(eEV_SPAWN, start, clock_NS()-start, err_handle, pid, 0);
+
+  free(cargv);
+  free(cmdline);
+  return pid;
+}
+
+void child_WAIT(child_t child)
+/* Wait for the CHILD process to exit. */
+{
+  if (pool_WAIT(child, NULL)) return;
+  trace_JOIN(child);
+  _BLOCKING("waitpid", -1, false, 0);
+  while (waitpid(child, NULL, 0) == -1 && errno == EINTR) continue;
+}
+
+int pipe_OPEN(int pfds[2], int pipe_size)
+/* Create a pipe with a capacity of PIPE-SIZE, the kernel's default
+   when 0, whose endpoints are not inherited by child processes. Return
+   0 on success.
+
+   The kernel rounds PIPE-SIZE up to a power of two number of pages,
+   and refuses it above /proc/sys/fs/pipe-max-size to unprivileged
+   processes, which leaves the default capacity. `pipe_CAPACITY'
+   returns what was granted.
+*/
+{
+  int rc = pipe2 (pfds, O_CLOEXEC);
+  if (rc == 0 && pipe_size > 0 && fcntl(pfds[1], F_SETPIPE_SZ, pipe_size) == -1)
+    _RPT_D(":pipe-size %d :refused %s\n", pipe_size, strerror(errno));
+  return rc;
+}
+
+fhandle_t fd_INHERITABLE(int fd)
+/* Return a duplicate of FD that is inherited across exec. FD is
+   closed.
+*/
+{
+  int handle = fcntl(fd, F_DUPFD, STDERR_FILENO+1);
+  ASSERT( handle != -1 );
+  _close(fd);
+  return handle;
+}
+
+void handle_CLOSE(fhandle_t handle)
+/* Close HANDLE, as returned by `fd_INHERITABLE'. */
+{
+  _close(handle);
+}
+
+static int64_t io_SYSCW(pid_t pid)
+/* Return the write syscalls process PID issued so far, as found in
+   /proc/PID/io, or -1 when unknown. */
+{
+  int64_t write_syscalls = -1;
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/%ld/io", (long)pid);
+  FILE* io = fopen(path, "r");
+  if (io)
+    {
+      char line[64]; long long syscw;
+      while (fgets(line, sizeof(line), io))
+	if (sscanf(line, "syscw: %lld", &syscw) == 1) write_syscalls = syscw;
+      fclose(io);
+    }
+  return write_syscalls;
+}
+
+void child_REAP(child_t child, struct CHILD_STATS* stats)
+/* Wait for the CHILD process to exit, keeping the watchdog at bay,
+   and fill in STATS with the resources it used. 
+
+   The child is left a zombie until its write syscalls are read from
+   /proc/PID/io.
+*/
+{
+  if (pool_WAIT(child, stats)) return;
+  trace_JOIN(child);
+  for (;;)
+    {
+      siginfo_t si; memset(&si, 0, sizeof(si));
+      int rc = waitid(P_PID, child, &si, WEXITED | WNOWAIT | WNOHANG);
+      if (rc == -1 && errno == EINTR) continue;
+      ASSERT( rc == 0 );
+      if (si.si_pid == child) break;
+      _KICK();
+      struct timespec ts = { 0, 1000000 };
+      nanosleep(&ts, NULL);
+    }
+
+  stats->write_syscalls = io_SYSCW(child);
+
+  struct rusage ru;
+  while (wait4(child, NULL, 0, &ru) == -1 && errno == EINTR) continue;
+  stats->cpu_ns =
+    ((uint64_t)ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000
+    + ((uint64_t)ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000;
+}
+
+uint64_t cpu_NS(void)
+/* Return the CPU time used by this process so far in ns. */
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int pipe_CAPACITY(int fd)
+/* Return the size of the buffer of the pipe whose read endpoint is FD. */
+{
+  return fcntl(fd, F_GETPIPE_SZ);
+}
+
+int pty_OPEN(int fds[2])
+/* Create a pseudo terminal with the default line discipline, and place
+   its master side in FDS[0] and its slave side in FDS[1], neither of
+   which is inherited by child processes. Return 0 on success.
+
+   Once the slave side is closed everywhere, reading the master side
+   fails with EIO.
+*/
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (master == -1) return -1;
+  char const * slave_name;
+  if (grantpt(master) || unlockpt(master) || !(slave_name = ptsname(master)))
+    {
+      _close(master);
+      return -1;
+    }
+  int slave = open(slave_name, O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (slave == -1)
+    {
+      _close(master);
+      return -1;
+    }
+  fds[0] = master; fds[1] = slave;
+  return 0;
+}
+
+/* capacity of a shared memory ring, a power of 2 as large as a default
+   pipe's */
+#define _SHM_RING_SIZE (1<<16)
+
+/* A single producer, single consumer ring of chars. The free running
+   counters are only ever written by their own side and each side
+   waits on the other's counter with futex() after it raised its
+   waiting flag, which the other side checks after each update. */
+struct SHM_RING {
+  uint32_t head;            /* chars consumed, by the reader */
+  uint32_t reader_waiting;
+  uint32_t reader_closed;
+  char pad1[64-3*sizeof(uint32_t)];
+  uint32_t tail;            /* chars produced, by the writer */
+  uint32_t writer_waiting;
+  uint32_t writer_closed;
+  char pad2[64-3*sizeof(uint32_t)];
+  char data[_SHM_RING_SIZE];
+};
+
+static void shm_FUTEX(uint32_t* addr, int op, uint32_t val)
+/* Wait on ADDR while it holds VAL (OP is FUTEX_WAIT) or wake up a
+   waiter on ADDR (FUTEX_WAKE). */
+{
+  syscall(SYS_futex, addr, op, val, NULL, NULL, 0);
+}
+
+struct SHM_RING* shm_OPEN(int* fd)
+/* Create a shared memory ring in a new memory file, placing the file's
+   descriptor, not inherited by child processes, in FD. Return the
+   ring mapped into our address space or NULL on error. */
+{
+  *fd = memfd_create("stest-shm-ring", MFD_CLOEXEC);
+  if (*fd == -1) return NULL;
+  if (ftruncate(*fd, sizeof(struct SHM_RING)))
+    {
+      _close(*fd);
+      return NULL;
+    }
+  struct SHM_RING* ring = shm_MAP(*fd);
+  if (!ring) _close(*fd);
+  return ring;
+}
+
+struct SHM_RING* shm_MAP(int fd)
+/* Map the shared memory ring in memory file FD, as created by
+   `shm_OPEN', into our address space. Return NULL on error. */
+{
+  void* ring = mmap(NULL, sizeof(struct SHM_RING), PROT_READ|PROT_WRITE,
+		    MAP_SHARED, fd, 0);
+  return ring == MAP_FAILED ? NULL : ring;
+}
+
+struct STALLS* stalls_OPEN(int* fd)
+/* Create the `STALLS' of a child in a new, zeroed, memory file,
+   placing the file's descriptor, not inherited by child processes, in
+   FD. Return them mapped into our address space or NULL on error. */
+{
+  *fd = memfd_create("stest-stalls", MFD_CLOEXEC);
+  if (*fd == -1) return NULL;
+  if (ftruncate(*fd, sizeof(struct STALLS)))
+    {
+      _close(*fd);
+      return NULL;
+    }
+  struct STALLS* stalls = stalls_MAP(*fd);
+  if (!stalls) _close(*fd);
+  return stalls;
+}
+
+struct STALLS* stalls_MAP(int fd)
+/* Map the `STALLS' in memory file FD, as created by `stalls_OPEN',
+   into our address space. Return NULL on error. */
+{
+  void* stalls = mmap(NULL, sizeof(struct STALLS), PROT_READ|PROT_WRITE,
+		      MAP_SHARED, fd, 0);
+  return stalls == MAP_FAILED ? NULL : stalls;
+}
+
+void stalls_CLOSE(struct STALLS* stalls)
+/* Unmap STALLS, as mapped by `stalls_MAP'. */
+{
+  munmap(stalls, sizeof(*stalls));
+}
+
+int shm_READ(struct SHM_RING* ring, char* buffer, int size)
+/* Read up to SIZE chars from RING into BUFFER, waiting for some to be
+   written if there are none. Return the count of chars read, or 0
+   once the writer has closed the ring and all was read. */
+{
+  uint32_t head = ring->head, tail;
+  for (;;)
+    {
+      tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+      if (tail != head) break;
+      if (__atomic_load_n(&ring->writer_closed, __ATOMIC_ACQUIRE))
+	{
+	  tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	  if (tail != head) break;
+	  return 0;
+	}
+      __atomic_store_n(&ring->reader_waiting, 1, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head
+	  && !__atomic_load_n(&ring->writer_closed, __ATOMIC_SEQ_CST))
+	shm_FUTEX(&ring->tail, FUTEX_WAIT, head);
+      __atomic_store_n(&ring->reader_waiting, 0, __ATOMIC_RELAXED);
+    }
+
+  uint32_t count = tail - head;
+  if (count > (uint32_t)size) count = size;
+  uint32_t at = head & (_SHM_RING_SIZE-1);
+  uint32_t first = count < _SHM_RING_SIZE-at ? count : _SHM_RING_SIZE-at;
+  memcpy(buffer, ring->data+at, first);
+  memcpy(buffer+first, ring->data, count-first);
+  __atomic_store_n(&ring->head, head+count, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&ring->writer_waiting, __ATOMIC_SEQ_CST))
+    shm_FUTEX(&ring->head, FUTEX_WAKE, 1);
+  return count;
+}
+
+int shm_WRITE(struct SHM_RING* ring, char const * buffer, int size)
+/* Write SIZE chars of BUFFER to RING, waiting for space whenever it is
+   full. Return SIZE, or -1 when the reader has closed the ring. */
+{
+  uint32_t tail = ring->tail;
+  for (int put=0;put<size;)
+    {
+      uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&ring->reader_closed, __ATOMIC_ACQUIRE)) return -1;
+      if (tail - head == _SHM_RING_SIZE)
+	{
+	  __atomic_store_n(&ring->writer_waiting, 1, __ATOMIC_SEQ_CST);
+	  if (__atomic_load_n(&ring->head, __ATOMIC_SEQ_CST) == head
+	      && !__atomic_load_n(&ring->reader_closed, __ATOMIC_SEQ_CST))
+	    shm_FUTEX(&ring->head, FUTEX_WAIT, head);
+	  __atomic_store_n(&ring->writer_waiting, 0, __ATOMIC_RELAXED);
+	  continue;
+	}
+
+      uint32_t count = _SHM_RING_SIZE - (tail - head);
+      if (count > (uint32_t)(size-put)) count = size-put;
+      uint32_t at = tail & (_SHM_RING_SIZE-1);
+      uint32_t first = count < _SHM_RING_SIZE-at ? count : _SHM_RING_SIZE-at;
+      memcpy(ring->data+at, buffer+put, first);
+      memcpy(ring->data, buffer+put+first, count-first);
+      tail += count; put += count;
+      __atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+      if (__atomic_load_n(&ring->reader_waiting, __ATOMIC_SEQ_CST))
+	shm_FUTEX(&ring->tail, FUTEX_WAKE, 1);
+    }
+  return size;
+}
+
+void shm_CLOSE(struct SHM_RING* ring, bool writer)
+/* Mark RING closed by the WRITER, or by the reader, waking the other
+   side up, and unmap it. */
+{
+  __atomic_store_n(writer ? &ring->writer_closed : &ring->reader_closed, 1,
+		   __ATOMIC_SEQ_CST);
+  shm_FUTEX(writer ? &ring->tail : &ring->head, FUTEX_WAKE, 1);
+  munmap(ring, sizeof(struct SHM_RING));
+}
+#endif
+
+char const * reader_NAME(enum e_args kind)
+/* Return the name of the reader KIND as given on the command line. */
+{
+  return kind==eREAD_EPOLL ? "epoll" : kind==eREAD_URING ? "uring" : "blocking";
+}
+
+#ifdef _WIN32
+void reader_OPEN(struct READER* reader, enum e_args kind, intptr_t handle, bool sock)
+/* Prepare READER to read from HANDLE, a socket when SOCK is set. Only
+   blocking reads are supported.
+*/
+{
+  if (kind != eREAD_BLOCKING) RPT(":reader %s :unsupported-on-this-platform\n", reader_NAME(kind));
+  ASSERT( kind == eREAD_BLOCKING );
+  reader->kind = kind; reader->handle = handle; reader->sock = sock;
+  reader->syscalls = 0; reader->bytes = 0;
+}
+
+int reader_READ(struct READER* reader, char* buffer, int size)
+/* Read up to SIZE chars into BUFFER, see `_read'. */
+{
+  reader->syscalls++;
+  _BLOCKING("read", (int)reader->handle, false, reader->bytes);
+  int read = reader->sock
+    ? recv((SOCKET)reader->handle, buffer, size, 0)
+    : _read((int)reader->handle, buffer, size);
+  if (read > 0) reader->bytes += read;
+  return read;
+}
+
+void reader_CLOSE(struct READER* reader)
+/* Release the resources of READER, but not its handle. */
+{
+  (void) reader;
+}
+#else
+/* multishot reads, not in <linux/io_uring.h> before 6.7 */
+#define _IORING_OP_READ_MULTISHOT 49
+/* the provided buffers ring, a power of 2 */
+#define _URING_BUFS 16
+#define _URING_BUF_SIZE (1<<16)
+
+/* an io_uring instance with a single read request in flight, whose
+   data land in a ring of provided buffers */
+struct URING {
+  int fd;
+  void* rings; size_t rings_size;
+  struct io_uring_sqe* sqes; size_t sqes_size;
+  unsigned *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  struct io_uring_cqe* cqes;
+
+  struct io_uring_buf_ring* br; char* bufs; unsigned short br_tail;
+  bool multishot;     /* cleared when the kernel does not support it */
+  bool armed;         /* a read request is in flight */
+  int to_submit;
+  bool eof;
+  int bid; char* data; int left; /* the buffer being consumed */
+};
+
+static void uring_RECYCLE(struct URING* u, int bid)
+/* Give the provided buffer BID back to the kernel. */
+{
+  struct io_uring_buf* buf = &u->br->bufs[u->br_tail & (_URING_BUFS-1)];
+  buf->addr = (uintptr_t)(u->bufs + (size_t)bid*_URING_BUF_SIZE);
+  buf->len = _URING_BUF_SIZE;
+  buf->bid = bid;
+  __atomic_store_n(&u->br->tail, ++u->br_tail, __ATOMIC_RELEASE);
+}
+
+static void uring_ARM(struct URING* u, int fd)
+/* Queue a read request of FD with buffer selection, multishot when
+   supported. */
+{
+  unsigned tail = *u->sq_tail, index = tail & *u->sq_mask;
+  struct io_uring_sqe* sqe = &u->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = u->multishot ? _IORING_OP_READ_MULTISHOT : IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 0;
+  sqe->off = -1;
+  u->sq_array[index] = index;
+  __atomic_store_n(u->sq_tail, tail+1, __ATOMIC_RELEASE);
+  u->armed = true; u->to_submit++;
+}
+
+void reader_OPEN(struct READER* reader, enum e_args kind, intptr_t handle, bool sock)
+/* Prepare READER to read from HANDLE, a socket when SOCK is set, with
+   the KIND engine:
+
+   `eREAD_BLOCKING' => a blocking `_read' or `recv' per read.
+   `eREAD_EPOLL'    => HANDLE is made non-blocking and read until it
+                       would block, then waited for with epoll_wait().
+   `eREAD_URING'    => multishot io_uring reads (or single shot ones,
+                       re-armed after each completion, on terminals and
+                       kernels before 6.7) into a ring of provided
+                       buffers, which are copied out as requested.
+*/
+{
+  memset(reader, 0, sizeof(*reader));
+  reader->kind = kind; reader->handle = handle; reader->sock = sock;
+  reader->epfd = -1;
+  int fd = (int)handle;
+  switch (kind)
+    {
+    case eREAD_EPOLL:
+      {
+	int rc = fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	ASSERT( rc == 0 );
+	reader->epfd = epoll_create1(EPOLL_CLOEXEC);
+	ASSERT( reader->epfd != -1 );
+	struct epoll_event event = { .events = EPOLLIN, .data.fd = fd };
+	rc = epoll_ctl(reader->epfd, EPOLL_CTL_ADD, fd, &event);
+	ASSERT( rc == 0 );
+	break;
+      }
+    case eREAD_URING:
+      {
+	struct URING* u = reader->uring = calloc(1, sizeof(struct URING)); ASSERT(u);
+	struct io_uring_params params; memset(&params, 0, sizeof(params));
+	u->fd = syscall(__NR_io_uring_setup, 4, &params);
+	if (u->fd == -1) RPT(":reader uring :unavailable :errno %d\n", errno);
+	ASSERT( u->fd != -1 );
+	ASSERT( params.features & IORING_FEAT_SINGLE_MMAP );
+
+	size_t sq_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+	size_t cq_size = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+	u->rings_size = sq_size > cq_size ? sq_size : cq_size;
+	u->rings = mmap(NULL, u->rings_size, PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	ASSERT( u->rings != MAP_FAILED );
+	u->sqes_size = params.sq_entries*sizeof(struct io_uring_sqe);
+	u->sqes = mmap(NULL, u->sqes_size, PROT_READ|PROT_WRITE,
+		       MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	ASSERT( u->sqes != MAP_FAILED );
+	char* rings = u->rings;
+	u->sq_tail = (unsigned*)(rings + params.sq_off.tail);
+	u->sq_mask = (unsigned*)(rings + params.sq_off.ring_mask);
+	u->sq_array = (unsigned*)(rings + params.sq_off.array);
+	u->cq_head = (unsigned*)(rings + params.cq_off.head);
+	u->cq_tail = (unsigned*)(rings + params.cq_off.tail);
+	u->cq_mask = (unsigned*)(rings + params.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe*)(rings + params.cq_off.cqes);
+
+	u->br = mmap(NULL, _URING_BUFS*sizeof(struct io_uring_buf), PROT_READ|PROT_WRITE,
+		     MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	ASSERT( u->br != MAP_FAILED );
+	struct io_uring_buf_reg reg; memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uintptr_t)u->br; reg.ring_entries = _URING_BUFS; reg.bgid = 0;
+	int rc = syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+	ASSERT( rc == 0 );
+	u->bufs = malloc((size_t)_URING_BUFS*_URING_BUF_SIZE); ASSERT(u->bufs);
+	for (int b=0;b<_URING_BUFS;b++) uring_RECYCLE(u, b);
+	// a multishot read waits forever on a terminal, whose reads can
+	// not be attempted without blocking
+	struct stat st;
+	u->multishot = !fstat(fd, &st) && (S_ISFIFO(st.st_mode) || S_ISSOCK(st.st_mode));
+	break;
+      }
+    default: break;
+    }
+}
+
+static int reader_FETCH(struct READER* reader, char* buffer, int size)
+/* Read up to SIZE chars into BUFFER with READER's engine, see
+   `reader_READ'. */
+{
+  int fd = (int)reader->handle;
+  switch (reader->kind)
+    {
+    case eREAD_EPOLL:
+      for (;;)
+	{
+	  reader->syscalls++;
+	  int read = reader->sock ? recv(fd, buffer, size, 0) : _read(fd, buffer, size);
+	  if (read != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) return read;
+	  struct epoll_event event;
+	  reader->syscalls++;
+	  int rc = epoll_wait(reader->epfd, &event, 1, -1);
+	  ASSERT( rc != -1 || errno == EINTR );
+	}
+    case eREAD_URING:
+      {
+	struct URING* u = reader->uring;
+	for (;;)
+	  {
+	    if (u->left)
+	      {
+		int take = size < u->left ? size : u->left;
+		memcpy(buffer, u->data, take);
+		u->data += take; u->left -= take;
+		if (!u->left) uring_RECYCLE(u, u->bid);
+		return take;
+	      }
+	    if (u->eof) return 0;
+
+	    unsigned head = *u->cq_head;
+	    if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+	      {
+		if (!u->armed) uring_ARM(u, fd);
+		reader->syscalls++;
+		int rc = syscall(__NR_io_uring_enter, u->fd, u->to_submit, 1,
+				 IORING_ENTER_GETEVENTS, NULL, 0);
+		if (rc >= 0) u->to_submit = 0;
+		ASSERT( rc >= 0 || errno == EINTR );
+		continue;
+	      }
+	    struct io_uring_cqe* cqe = &u->cqes[head & *u->cq_mask];
+	    int res = cqe->res; unsigned flags = cqe->flags;
+	    __atomic_store_n(u->cq_head, head+1, __ATOMIC_RELEASE);
+	    if (!(flags & IORING_CQE_F_MORE)) u->armed = false;
+
+	    if (flags & IORING_CQE_F_BUFFER)
+	      {
+		int bid = flags >> IORING_CQE_BUFFER_SHIFT;
+		if (res > 0) { u->bid = bid; u->data = u->bufs + (size_t)bid*_URING_BUF_SIZE; u->left = res; }
+		else uring_RECYCLE(u, bid);
+	      }
+	    if (res == -EINVAL && u->multishot) { u->multishot = false; continue; }
+	    // out of buffers, re-armed once the queued data are consumed
+	    if (res == -ENOBUFS) continue;
+	    if (res < 0) { errno = -res; return -1; }
+	    if (res == 0) u->eof = true;
+	  }
+      }
+    default:
+      reader->syscalls++;
+      return reader->sock ? recv(fd, buffer, size, 0) : _read(fd, buffer, size);
+    }
+}
+
+int reader_READ(struct READER* reader, char* buffer, int size)
+/* Read up to SIZE chars into BUFFER. Like `_read', return the count of
+   chars read, 0 at the end of input or -1 on error.
+*/
+{
+  _BLOCKING("read", (int)reader->handle, false, reader->bytes);
+  uint64_t before = _TIMELINE ? clock_NS() : 0;
+  int read = reader_FETCH(reader, buffer, size);
+  if (read > 0) reader->bytes += read;
+  if (_TIMELINE)
+    timeline_ADD(eEV_READ, before, clock_NS()-before, (int)reader->handle, read, 0);
+  return read;
+}
+
+void reader_CLOSE(struct READER* reader)
+/* Release the resources of READER, but not its handle. */
+{
+  if (reader->epfd != -1) _close(reader->epfd);
+  struct URING* u = reader->uring;
+  if (u)
+    {
+      _close(u->fd);
+      munmap(u->rings, u->rings_size);
+      munmap(u->sqes, u->sqes_size);
+      munmap(u->br, _URING_BUFS*sizeof(struct io_uring_buf));
+      free(u->bufs);
+      free(u);
+    }
+}
+#endif
+
+void pipe_test(int pipe_size, int write_count, int read_count)
+/* Create a _pipe() of PIPE_SIZE. Write WRITE-COUNT '$' chars to
+   pipe's write endpoint and then read READ-COUNT chars from pipe's
+   read endpoint. 
+*/
+{
+  char* msg = malloc(write_count); ASSERT(msg);
+  memset(msg, '$', sizeof(char)*write_count);
+  
+  enum { READ, WRITE };
+  int pfds[2];
+  int rc = pipe_OPEN (pfds, pipe_size);
+  ASSERT( rc == 0 );
+
+  
+  RPT(":pipe-size %d :pipe-capacity %d :writing-bytes %d\n",
+	pipe_size, pipe_CAPACITY(pfds[READ]), write_count);
+  _BLOCKING("write", pfds[WRITE], true, 0);
+  int wrote_count = _write(pfds[WRITE], msg, write_count);
+  ASSERT( wrote_count == write_count);
+  free(msg);
+
+  char* read_buffer = calloc(read_count+1, sizeof(char)); ASSERT(read_buffer);
+    
+  RPT(":reading-bytes %d\n",
+	read_count);
+  _BLOCKING("read", pfds[READ], false, 0);
+  int read = _read(pfds[READ], read_buffer, read_count);
+
+  RPT(":read-bytes %d :read-chars %s\n",
+	read, read_buffer);
+  free(read_buffer);
+
+  _close(pfds[READ]);
+  _close(pfds[WRITE]);
+}
+      
+void pipe_handle_to_child(int pipe_size, int write_count, int read_count,
+			  enum e_args reader)
+/* Create a _pipe() of PIPE_SIZE. Spawn a child passing the pipe's
+   write handle as command line argument to the child. The child
+   writes WRITE-COUNT '$' chars to the write handle while the parent
+   reads READ-COUNT chars with the READER engine (see `reader_OPEN').
+*/
+{
+  enum { READ, WRITE };
+  int pfds[2];
+  int rc = pipe_OPEN (pfds, pipe_size);
+  ASSERT( rc == 0 );
+  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+
+      
+  int cmdargs_size = 1;
+  cmdargs_size+=snprintf(NULL, 0, ":to-handle %lld %d",
+			 (long long)(intptr_t)write_handle, write_count);
+  char cmdargs[cmdargs_size];
+  snprintf(cmdargs, cmdargs_size, ":to-handle %lld %d",
+	   (long long)(intptr_t)write_handle, write_count);
+
+  child_t child = child_SPAWN(cmdargs, _NO_FHANDLE); ASSERT ( child );
+  
+  char* read_buffer = calloc(read_count+1, sizeof(char)); ASSERT(read_buffer);
+    
+  RPT(":pipe-size %d :pipe-capacity %d :reading-bytes %d\n",
+	pipe_size, pipe_CAPACITY(pfds[READ]), read_count);
+  struct READER rd;
+  reader_OPEN(&rd, reader, pfds[READ], false);
+  int read = reader_READ(&rd, read_buffer, read_count);
+  reader_CLOSE(&rd);
+
+  RPT(":read-bytes %d :read-chars %s\n",
+	read, read_buffer); fflush(stdout);
+  free(read_buffer);
+ 
+  child_WAIT(child);
+  RPT(":child-exited\n");
+
+  _close(pfds[READ]);
+    
+}
+
+
+void pipe_to_child_stderr(int pipe_size, int read_count, char const * cmdargs,
+			  enum e_args reader)
+/* Create a _pipe() of PIPE-SIZE. Spawn a new child process with
+   command line arguments CMDARGS, redirecting its stderr to the
+   pipe's write endpoint. The parent reads READ-COUNT chars from the
+   pipe's read endpoint with the READER engine (see `reader_OPEN').
+*/
+{
+  enum { READ, WRITE };
+  int pfds[2];
+  int rc = pipe_OPEN (pfds, pipe_size);
+  ASSERT( rc == 0 );
+  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+
+  child_t child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+
+  char* read_buffer = calloc(read_count+1, sizeof(char)); ASSERT(read_buffer);
+    
+  RPT(":pipe-size %d, :pipe-capacity %d, :read-req-bytes %d\n",
+	pipe_size, pipe_CAPACITY(pfds[READ]), read_count);
+  struct READER rd;
+  reader_OPEN(&rd, reader, pfds[READ], false);
+  int read = reader_READ(&rd, read_buffer, read_count);
+  reader_CLOSE(&rd);
+
+  RPT(":read-bytes %d :read-chars %s\n",
+	read, read_buffer); fflush(stdout);
+  free(read_buffer);
+  
+  // wait for child to exit
+  child_WAIT(child);
+  RPT(":child-exited\n");
+
+  _close(pfds[READ]);
+}
+
+child_t shm_SPAWN(char const * cmdargs, struct SHM_RING** ring)
+/* Create a shared memory ring (see `shm_OPEN') in RING and spawn a
+   child process with command line arguments CMDARGS, a :to-stderr
+   command, to write to it. */
+{
+  int fd;
+  *ring = shm_OPEN(&fd); ASSERT(*ring);
+  fhandle_t handle = fd_INHERITABLE (fd);
+
+  // :shm goes right after :to-stderr and its :quiet, if any
+  char const * subcmd = ":to-stderr", * quiet = " :quiet";
+  ASSERT(!strncmp(cmdargs, subcmd, strlen(subcmd)));
+  char const * rest = cmdargs+strlen(subcmd);
+  if (!strncmp(rest, quiet, strlen(quiet))) rest += strlen(quiet);
+  int head_len = rest-cmdargs;
+  int shm_cmdargs_size = 1;
+  shm_cmdargs_size+=snprintf(NULL, 0, "%.*s :shm %lld%s", head_len, cmdargs,
+			     (long long)(intptr_t)handle, rest);
+  char shm_cmdargs[shm_cmdargs_size];
+  snprintf(shm_cmdargs, shm_cmdargs_size, "%.*s :shm %lld%s", head_len, cmdargs,
+	   (long long)(intptr_t)handle, rest);
+
+  child_t child = child_SPAWN(shm_cmdargs, _NO_FHANDLE); ASSERT(child);
+  handle_CLOSE(handle);
+  return child;
+}
+
+void shm_to_child(int read_count, char const * cmdargs)
+/* Spawn a new child process with command line arguments CMDARGS,
+   writing to a shared memory ring (see `shm_SPAWN'). The parent reads
+   READ-COUNT chars from the ring.
+*/
+{
+  struct SHM_RING* ring;
+  child_t child = shm_SPAWN(cmdargs, &ring);
+
+  char* read_buffer = calloc(read_count+1, sizeof(char)); ASSERT(read_buffer);
+
+  RPT(":read-req-bytes %d\n", read_count);
+  int read = shm_READ(ring, read_buffer, read_count);
+
+  RPT(":read-bytes %d :read-chars %s\n",
+	read, read_buffer); fflush(stdout);
+  free(read_buffer);
+  shm_CLOSE(ring, false);
+
+  // wait for child to exit
+  child_WAIT(child);
+  RPT(":child-exited\n");
+}
+
+void pty_to_child_stderr(int read_count, char const * cmdargs, enum e_args reader)
+/* Create a pseudo terminal (see `pty_OPEN'). Spawn a new child process
+   with command line arguments CMDARGS, redirecting its stderr to the
+   terminal's slave side. The parent reads READ-COUNT chars from the
+   master side with the READER engine (see `reader_OPEN').
+*/
+{
+  enum { READ, WRITE };
+  int pfds[2];
+  int rc = pty_OPEN (pfds);
+  ASSERT( rc == 0 );
+  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+
+  child_t child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+  handle_CLOSE(write_handle);
+
+  char* read_buffer = calloc(read_count+1, sizeof(char)); ASSERT(read_buffer);
+    
+  RPT(":read-req-bytes %d\n", read_count);
+  struct READER rd;
+  reader_OPEN(&rd, reader, pfds[READ], false);
+  int read = reader_READ(&rd, read_buffer, read_count);
+  reader_CLOSE(&rd);
+
+  RPT(":read-bytes %d :read-chars %s\n",
+	read, read_buffer); fflush(stdout);
+  free(read_buffer);
+  
+  // wait for child to exit
+  child_WAIT(child);
+  RPT(":child-exited\n");
+
+  _close(pfds[READ]);
+}
+
+#ifdef _WIN32
+void socket_PAIR(SOCKET sfds[2])
+/* Create a pair of connected read/write TCP sockets in SFDS. The
+   write socket is created using the first available WSA TCP
+   "protocol" which can make the socket also act as a file handle. The
+   write socket is connected to the read socket.
+*/
+{
+  static bool wsa_started = false;
+  if (!wsa_started)
+    {
+      WSADATA wsa;
+      int rc = WSAStartup(MAKEWORD(2,2),&wsa);
+      ASSERT(rc == 0);
+      wsa_started = true;
+    }
+  
+  WSAPROTOCOL_INFO provider; memset(&provider, 0, sizeof(provider));
+  {
+    // locate the first TCP provider that can create a socket which
+    // can act as a file.
+    //
+    // see https://stackoverflow.com/questions/58324162/are-wsasockets-able-to-take-process-i-o-without-the-use-of-pipes
+    int protocol[] = { IPPROTO_TCP, 0 };
+
+    unsigned int buffer_size = 4096; /* a guess of an upper memory requirements */
+    BYTE buffer[buffer_size]; memset(&buffer, 0, sizeof(buffer));
+    WSAPROTOCOL_INFO* pinfo = (WSAPROTOCOL_INFO*)&buffer;
+    DWORD pinfo_size = sizeof(buffer);
+    _RPT_D(":tcp-providers-getting...\n");
+    int count = WSAEnumProtocols(protocol, pinfo, &pinfo_size);
+    ASSERT( pinfo_size<=buffer_size );
+    ASSERT(count > 0);
+    int iprovider = -1;
+    for (int i=0;i<count;i++)
+      {
+	_RPT_D(":provider %d :address-family %d :protocol %s :ifs? %s\n",
+	       i, pinfo[0].iAddressFamily, pinfo[i].szProtocol,
+	       pinfo[i].dwServiceFlags1 & XP1_IFS_HANDLES ? "true" : "false");
+	// keep a reference of the first one found
+	if (iprovider==-1
+	    && pinfo[i].dwServiceFlags1 & XP1_IFS_HANDLES) iprovider = i;
+      }
+
+    ASSERT(iprovider!=-1);
+    
+    provider=pinfo[iprovider];
+  }
+
+  static bool reported = false;
+  if (!reported) RPT(":socket-provider-IFS-selected %s\n", provider.szProtocol);
+  reported = true;
+  SOCKET socket_write = WSASocket(AF_INET, SOCK_STREAM, IPPROTO_TCP, &provider, 0, 0 );
+  ASSERT(socket_write  != INVALID_SOCKET);
+
+  SOCKET socket_listen = socket(AF_INET, SOCK_STREAM, 0 );
+  ASSERT(socket_listen != INVALID_SOCKET);
+  
+  struct sockaddr_in server;
+  server.sin_family = AF_INET;
+  server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  server.sin_port = 0; // any available port
+  
+  _RPT_D(":socket-read :binding...\n");
+  int rc = bind(socket_listen ,(struct sockaddr *)&server , sizeof(server));
+  ASSERT( rc != SOCKET_ERROR);
+  _RPT_D(":socket-read :listening...\n");
+  rc = listen(socket_listen , 1);
+  ASSERT( rc != SOCKET_ERROR);
+	
+  {
+    int addrlen = sizeof(server);
+    rc = getsockname(socket_listen, (struct sockaddr *)&server, &addrlen); ASSERT(!rc);
+    _RPT_D(":socket-read :port-opened %d\n", ntohs(server.sin_port));
+  }
+
+  // connect write socket to read socket, the connection is queued in
+  // the listen backlog until accepted.
+  _RPT_D(":socket-write :connecting...\n");
+  rc = connect(socket_write , (struct sockaddr *)&server , sizeof(server));
+  ASSERT(rc != SOCKET_ERROR);
+
+  struct sockaddr_in client;
+  int size = sizeof(struct sockaddr_in);
+  _RPT_D(":socket-read :accepting...\n");
+  SOCKET socket_read = accept(socket_listen , (struct sockaddr *)&client, &size);
+  ASSERT(socket_read!=INVALID_SOCKET);
+  closesocket(socket_listen);
+
+  enum { READ, WRITE };
+  sfds[READ] = socket_read;
+  sfds[WRITE] = socket_write;
+}
+#else
+void socket_PAIR(SOCKET sfds[2])
+/* Create a connected pair of read/write sockets in SFDS of the kind
+   in `_SOCK': Unix domain stream sockets with socketpair()
+   (`eSOCK_PAIR'), Unix domain stream sockets connected through a
+   listening socket on an abstract address (`eSOCK_UNIX'), Unix domain
+   sequenced packet sockets with socketpair() (`eSOCK_SEQPACKET') or
+   TCP sockets connected on the loopback interface (`eSOCK_TCP').
+   Neither is inherited by child processes.
+
+   The options in `_SOCK' are set on the write socket, but for the
+   receive buffer size, which is set on the read socket. The options
+   refused and the buffer sizes granted are reported along with the
+   kind of the pair, whenever either changes.
+*/
+{
+  enum { READ, WRITE };
+  char const * name = NULL;
+  switch (_SOCK.kind)
+    {
+    case eSOCK_PAIR: case eSOCK_SEQPACKET:
+      {
+	bool seq = _SOCK.kind == eSOCK_SEQPACKET;
+	int rc = socketpair(AF_UNIX, (seq ? SOCK_SEQPACKET : SOCK_STREAM) | SOCK_CLOEXEC,
+			    0, sfds);
+	ASSERT(rc == 0);
+	name = seq ? "AF_UNIX SOCK_SEQPACKET" : "AF_UNIX SOCK_STREAM";
+	break;
+      }
+    default:
+      {
+	ASSERT( _SOCK.kind == eSOCK_UNIX || _SOCK.kind == eSOCK_TCP );
+	bool tcp = _SOCK.kind == eSOCK_TCP;
+	struct sockaddr_storage ss; memset(&ss, 0, sizeof(ss));
+	socklen_t ss_len;
+	if (tcp)
+	  {
+	    struct sockaddr_in* in = (struct sockaddr_in*)&ss;
+	    in->sin_family = AF_INET;
+	    in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	    ss_len = sizeof(*in);
+	    name = "AF_INET SOCK_STREAM :loopback";
+	  }
+	else
+	  {
+	    // an abstract address, which leaves nothing behind
+	    static int pairs = 0;
+	    struct sockaddr_un* un = (struct sockaddr_un*)&ss;
+	    un->sun_family = AF_UNIX;
+	    int path_len = snprintf(un->sun_path+1, sizeof(un->sun_path)-1, "stest.%ld.%d",
+				    (long)getpid(), pairs++);
+	    ss_len = offsetof(struct sockaddr_un, sun_path)+1+path_len;
+	    name = "AF_UNIX SOCK_STREAM :connected";
+	  }
+	int family = tcp ? AF_INET : AF_UNIX;
+	int lfd = socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT( lfd != -1 );
+	ASSERT( !bind(lfd, (struct sockaddr*)&ss, ss_len) );
+	ASSERT( !listen(lfd, 1) );
+	// the port picked, for TCP
+	ASSERT( !getsockname(lfd, (struct sockaddr*)&ss, &ss_len) );
+	sfds[WRITE] = socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	ASSERT( sfds[WRITE] != -1 );
+	ASSERT( !connect(sfds[WRITE], (struct sockaddr*)&ss, ss_len) );
+	sfds[READ] = accept4(lfd, NULL, NULL, SOCK_CLOEXEC);
+	ASSERT( sfds[READ] != -1 );
+	close(lfd);
+      }
+    }
+
+  char refused[64] = "";
+  int one = 1;
+#define _SOCK_OPT(FD, LEVEL, OPT, VAL, NAME)				\
+  if (setsockopt(FD, LEVEL, OPT, &(VAL), sizeof(int)))			\
+    strncat(refused, " " NAME, sizeof(refused)-strlen(refused)-1);
+  if (_SOCK.sndbuf) _SOCK_OPT(sfds[WRITE], SOL_SOCKET, SO_SNDBUF, _SOCK.sndbuf, "sndbuf");
+  if (_SOCK.rcvbuf) _SOCK_OPT(sfds[READ], SOL_SOCKET, SO_RCVBUF, _SOCK.rcvbuf, "rcvbuf");
+  if (_SOCK.nodelay) _SOCK_OPT(sfds[WRITE], IPPROTO_TCP, TCP_NODELAY, one, "nodelay");
+  if (_SOCK.cork) _SOCK_OPT(sfds[WRITE], IPPROTO_TCP, TCP_CORK, one, "cork");
+  if (_SOCK.zerocopy) _SOCK_OPT(sfds[WRITE], SOL_SOCKET, SO_ZEROCOPY, one, "zerocopy");
+#undef _SOCK_OPT
+
+  // the kernel doubles the sizes asked for, for its own bookkeeping
+  int sndbuf = 0, rcvbuf = 0;
+  socklen_t opt_len = sizeof(int);
+  getsockopt(sfds[WRITE], SOL_SOCKET, SO_SNDBUF, &sndbuf, &opt_len);
+  opt_len = sizeof(int);
+  getsockopt(sfds[READ], SOL_SOCKET, SO_RCVBUF, &rcvbuf, &opt_len);
+
+  static struct SOCK_OPTS reported; static bool reported_once = false;
+  if (!reported_once || memcmp(&reported, &_SOCK, sizeof(reported)))
+    RPT(":socket-pair-selected %s :sndbuf %d :rcvbuf %d%s%s%s%s%s\n", name,
+	sndbuf, rcvbuf,
+	_SOCK.nodelay ? " :nodelay" : "", _SOCK.cork ? " :cork" : "",
+	_SOCK.zerocopy ? " :zerocopy" : "", *refused ? " :refused" : "", refused);
+  reported = _SOCK; reported_once = true;
+}
+#endif
+
+struct THREAD_ARGS {
+  SOCKET socket_read;
+  int read_count;
+  enum e_args reader;
+};
+
+#ifdef _WIN32
+DWORD socket_READ(LPVOID _args)
+#else
+void* socket_READ(void* _args)
+#endif
+/* read _ARGS.read_count chars from socket _ARGS.socket_read with the
+   _ARGS.reader engine. _ARGS is of type `THREAD_ARGS'.
+*/
+{
+  struct THREAD_ARGS* args = (struct THREAD_ARGS*) _args;
+  char* read_buffer = calloc(1+args->read_count, sizeof(char)); ASSERT(read_buffer);
+  RPT(":reading-bytes %d\n", args->read_count);
+  struct READER rd;
+  reader_OPEN(&rd, args->reader, args->socket_read, true);
+  int recv_size = reader_READ(&rd, read_buffer, args->read_count);
+  ASSERT(recv_size != SOCKET_ERROR);
+  reader_CLOSE(&rd);
+  
+  RPT(":read-bytes %d :read-chars %s\n", recv_size, read_buffer);
+  free(read_buffer);
+  
+  _RPT_D(":thread-exiting...\n");
+
+  return 0;
+}
+
+void socket_to_child_stderr(int read_count, char const * cmdargs, enum e_args reader)
+/* Create a pair of connected read/write sockets (see `socket_PAIR').
+
+   Spawns a child process with command line arguments CMDARGS. The
+   child stderr is redirected to the write socket. 
+
+   It reads READ-COUNT characters from the read socket with the READER
+   engine (see `reader_OPEN').
+*/
+{
+  enum { READ, WRITE };
+  SOCKET sfds[2];
+  socket_PAIR(sfds);
+	
+  // create a thread to read from the read socket
+  struct THREAD_ARGS args;
+  args.socket_read = sfds[READ];
+  args.read_count = read_count;
+  args.reader = reader;
+#ifdef _WIN32
+  DWORD threadID;
+  HANDLE thread = CreateThread(NULL, 0, socket_READ, &args, 0,&threadID); 
+  ASSERT(thread != NULL);
+#else
+  pthread_t thread;
+  int rc = pthread_create(&thread, NULL, socket_READ, &args);
+  ASSERT(rc == 0);
+#endif
+  
+  child_t child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+
+  child_WAIT(child);
+  RPT(":child-exited\n");
+  
+#ifdef _WIN32
+  WaitForSingleObject(thread, INFINITE );
+#else
+  pthread_join(thread, NULL);
+#endif
+  _RPT_D(":thread-exited\n");         
+  closesocket(sfds[READ]);
+  closesocket(sfds[WRITE]);	  
+}
+
+void latency_to_child_stderr(enum e_args via, int pipe_size, int runs, int record_len,
+			     char const * cmdargs, enum e_args reader)
+/* Repeat RUNS times: create a _pipe() of PIPE-SIZE (VIA is
+   `eVIA_PIPE'), a pair of sockets (`eVIA_SOCK'), a pseudo terminal
+   (`eVIA_PTY') or a shared memory ring (`eVIA_SHM'), and spawn a child
+   process with command line arguments CMDARGS, a :to-stderr command,
+   and its stderr redirected to the write endpoint, or writing to the
+   ring. The child is expected to write a timestamped record of
+   RECORD-LEN chars (see `stamp_SET').
+
+   The parent reads the record with the READER engine (see
+   `reader_OPEN') and takes the time the first byte of it arrived. The
+   distribution of the delays between the timestamp and the arrival is
+   reported as a histogram.
+*/
+{
+  struct HISTOGRAM* hist = calloc(1, sizeof(struct HISTOGRAM)); ASSERT(hist);
+  char* record = malloc(record_len+1); ASSERT(record);
+
+  bool sock = via == eVIA_SOCK;
+  RPT(":latency-runs %d :reader %s :child-cmd %s\n", runs, reader_NAME(reader), cmdargs);
+  for (int run=0;run<runs;run++)
+    {
+      enum { READ, WRITE };
+      intptr_t read_handle = -1;
+      struct SHM_RING* ring = NULL;
+      child_t child;
+      if (sock)
+	{
+	  SOCKET sfds[2];
+	  socket_PAIR(sfds);
+	  child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+	  closesocket(sfds[WRITE]);
+	  read_handle = sfds[READ];
+	}
+      else if (via == eVIA_SHM)
+	child = shm_SPAWN(cmdargs, &ring);
+      else
+	{
+	  int pfds[2];
+	  int rc = via == eVIA_PTY ? pty_OPEN (pfds) : pipe_OPEN (pfds, pipe_size);
+	  ASSERT( rc == 0 );
+	  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+	  child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+	  handle_CLOSE(write_handle);
+	  read_handle = pfds[READ];
+	}
+
+      memset(record, 0, record_len+1);
+      uint64_t arrived = 0;
+      int got = 0;
+      struct READER rd;
+      if (!ring) reader_OPEN(&rd, reader, read_handle, sock);
+      while (got < record_len)
+	{
+	  int read = ring
+	    ? shm_READ(ring, record+got, record_len-got)
+	    : reader_READ(&rd, record+got, record_len-got);
+	  if (read <= 0) break;
+	  if (!got) arrived = clock_NS();
+	  got += read;
+	}
+      if (!ring) reader_CLOSE(&rd);
+
+      child_WAIT(child);
+      if (ring) shm_CLOSE(ring, false);
+      else if (sock) closesocket((SOCKET)read_handle);
+      else _close((int)read_handle);
+
+      ASSERT(got == record_len);
+      unsigned long long stamped = 0;
+      int scanned = sscanf(record, "@%llu", &stamped);
+      ASSERT(scanned == 1 && stamped <= arrived);
+      hist_ADD(hist, arrived - stamped);
+      _KICK();
+    }
+
+  hist_RPT(hist, "latency");
+  free(record);
+  free(hist);
+}
+
+#ifdef _WIN32
+void threads_to_child_stderr(enum e_args via, int pipe_size, int read_count, int letters,
+			     char const * cmdargs, enum e_args reader)
+{
+  (void) via; (void) pipe_size; (void) read_count; (void) letters; (void) cmdargs;
+  (void) reader;
+  RPT(":writer-threads :unsupported-on-this-platform\n");
+}
+#else
+/* how the records of the :writer-threads arrive, see `tears_SCAN' */
+struct TEARS {
+  char mark;              /* of the thread the current run is from */
+  long long run;          /* its length so far */
+  long long records, torn_runs, interleaves;
+};
+
+static void tears_END(struct TEARS* tears, int letters)
+/* End the current run of TEARS, a whole number of records of LETTERS
+   marks unless a record was torn. */
+{
+  tears->records += tears->run / letters;
+  if (tears->run % letters) tears->torn_runs++;
+  tears->run = 0;
+}
+
+static void tears_SCAN(struct TEARS* tears, char const * buffer, int len, int letters)
+/* Follow the LEN chars of BUFFER in TEARS, as runs of the same mark
+   between new lines. Records of LETTERS marks written whole make runs
+   of a multiple of them; any other run is part of a record another
+   thread's write tore apart. */
+{
+  for (int i=0;i<len;i++)
+    {
+      char c = buffer[i];
+      // a terminal's \r included
+      if (c == '\n' || c == '\r') continue;
+      if (c != tears->mark)
+	{
+	  if (tears->run) { tears_END(tears, letters); tears->interleaves++; }
+	  tears->mark = c;
+	}
+      tears->run++;
+    }
+}
+
+void threads_to_child_stderr(enum e_args via, int pipe_size, int read_count, int letters,
+			     char const * cmdargs, enum e_args reader)
+/* Spawn a child process with command line arguments CMDARGS, a
+   :to-stderr command with :writer-threads, and its stderr redirected
+   to a _pipe() of PIPE-SIZE (VIA is `eVIA_PIPE'), a socket
+   (`eVIA_SOCK') or a pseudo terminal (`eVIA_PTY'). The parent reads
+   all that arrives in READ-COUNT chars at a time with the READER
+   engine (see `reader_OPEN'), records of LETTERS marks each (see
+   `threads_WRITE').
+
+   Reports the throughput the parent saw, the records that arrived
+   whole, the runs of a thread's marks that were part of a torn record
+   and the times the records of one thread were interleaved with
+   another's.
+*/
+{
+  enum { READ, WRITE };
+  bool sock = via == eVIA_SOCK;
+  intptr_t read_handle;
+  child_t child;
+  uint64_t start = clock_NS();
+  if (sock)
+    {
+      SOCKET sfds[2];
+      socket_PAIR(sfds);
+      child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+      closesocket(sfds[WRITE]);
+      read_handle = sfds[READ];
+    }
+  else
+    {
+      int pfds[2];
+      int rc = via == eVIA_PTY ? pty_OPEN (pfds) : pipe_OPEN (pfds, pipe_size);
+      ASSERT( rc == 0 );
+      fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+      child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+      handle_CLOSE(write_handle);
+      read_handle = pfds[READ];
+    }
+
+  char* chunk = malloc(read_count); ASSERT(chunk);
+  struct TEARS tears; memset(&tears, 0, sizeof(tears));
+  long long got = 0;
+  struct READER rd;
+  reader_OPEN(&rd, reader, read_handle, sock);
+  for (;;)
+    {
+      int read = reader_READ(&rd, chunk, read_count);
+      if (read <= 0) break;
+      tears_SCAN(&tears, chunk, read, letters);
+      got += read;
+      _KICK();
+    }
+  if (tears.run) tears_END(&tears, letters);
+  reader_CLOSE(&rd);
+  free(chunk);
+  if (sock) closesocket((SOCKET)read_handle); else _close((int)read_handle);
+
+  child_WAIT(child);
+  uint64_t elapsed = clock_NS()-start;
+  RPT(":writer-threads-read :transport %s :reader %s :mbytes %.1f :mb-per-s %.1f :records %lld"
+      " :torn-runs %lld :interleaves %lld :records-per-run %.1f\n",
+      sock ? "sock" : via == eVIA_PTY ? "pty" : "pipe", reader_NAME(reader),
+      got/1048576.0, got/1048576.0/(elapsed/1e9), tears.records, tears.torn_runs,
+      tears.interleaves, (double)tears.records/(tears.interleaves+1));
+  RPT(":child-exited\n");
+}
+#endif
+
+void throughput_BENCH(enum e_args via, int mbytes, int write_count,
+		      int pipe_size, enum e_args mode, int max_delay_us,
+		      int buffer_size, enum e_args reader, int read_rate, int pace,
+		      enum e_args stream, int call_bytes)
+/* Spawn a child process that writes MBYTES of '$' characters to its
+   stderr in fwrite()s of WRITE-COUNT chars, or through the :stream
+   kind STREAM when set, or in calls of CALL-BYTES chars with the
+   :write-api STREAM when CALL-BYTES is set, after changing the stderr
+   buffering MODE (when set) to use a buffer of BUFFER-SIZE, flushed
+   within MAX-DELAY-US when MODE is `eADAPTIVE'.
+
+   The child's stderr is redirected to a _pipe() of PIPE-SIZE (VIA is
+   `eVIA_PIPE'), to a socket (`eVIA_SOCK'), to a pseudo terminal
+   (`eVIA_PTY') or is inherited from the parent (`eVIA_INHERIT'). The
+   parent reads everything the child writes with the READER engine (see
+   `reader_OPEN'), unless inherited. With VIA `eVIA_SHM' the child
+   writes to a shared memory ring instead (see `shm_SPAWN').
+
+   Reports the throughput, the bytes per write and read syscall, the
+   syscalls the reader issued per MB and the CPU time of the parent and
+   the child.
+
+   With READ-RATE and PACE (bytes per second, unlimited when 0) the
+   parent reads and the child writes no faster than that. With either
+   set, the child also takes the time of each of its writes, and the
+   distribution of those is reported along with their sum, the time the
+   child was held back by the parent (see `STALLS').
+*/
+{
+  long long repeat = (((long long)mbytes<<20) + write_count-1) / write_count;
+  ASSERT(repeat <= INT_MAX);
+  long long volume = repeat * write_count;
+  if (via == eVIA_SHM) mode = 0;
+
+  char mode_args[48] = "";
+  if (mode == eUNBUF)
+    snprintf(mode_args, sizeof(mode_args), " :unbuf");
+  else if (mode == eADAPTIVE)
+    snprintf(mode_args, sizeof(mode_args), " :adaptive %d %d", max_delay_us, buffer_size);
+  else if (mode)
+    snprintf(mode_args, sizeof(mode_args), " %s %d",
+	     mode==eLNBUF ? ":lnbuf" : ":flbuf", buffer_size);
+  int stalls_fd = -1;
+  struct STALLS* stalls = NULL;
+  fhandle_t stalls_handle = _NO_FHANDLE;
+  char pace_args[48] = "";
+  if (read_rate || pace)
+    {
+      stalls = stalls_OPEN(&stalls_fd);
+      if (stalls) stalls_handle = fd_INHERITABLE(stalls_fd);
+      int len = 0;
+      if (pace) len = snprintf(pace_args, sizeof(pace_args), " :pace %d", pace);
+      if (stalls)
+	snprintf(pace_args+len, sizeof(pace_args)-len, " :stalls %lld",
+		 (long long)(intptr_t)stalls_handle);
+    }
+  char stream_args[40] = "";
+  if (call_bytes && via != eVIA_SHM)
+    snprintf(stream_args, sizeof(stream_args), " :write-api %s %d",
+	     stream_NAME(stream), call_bytes);
+  else if (stream && via != eVIA_SHM)
+    snprintf(stream_args, sizeof(stream_args), " :stream %s", stream_NAME(stream));
+  char cmdargs[160];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs),
+			      ":to-stderr :quiet :repeat %lld%s%s :write %d%s",
+			      repeat, pace_args, stream_args, write_count, mode_args);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+
+  enum { READ, WRITE };
+  bool sock = via == eVIA_SOCK;
+  intptr_t read_handle = -1;
+  struct SHM_RING* ring = NULL;
+  int capacity = 0;
+  uint64_t cpu_start = cpu_NS(), start = clock_NS();
+  child_t child;
+  switch (via)
+    {
+    case eVIA_PIPE: case eVIA_PTY:
+      {
+	int pfds[2];
+	int rc = via == eVIA_PTY ? pty_OPEN (pfds) : pipe_OPEN (pfds, pipe_size);
+	ASSERT( rc == 0 );
+	if (via == eVIA_PIPE) capacity = pipe_CAPACITY(pfds[READ]);
+	fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+	child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+	handle_CLOSE(write_handle);
+	read_handle = pfds[READ];
+	break;
+      }
+    case eVIA_SOCK:
+      {
+	SOCKET sfds[2];
+	socket_PAIR(sfds);
+	child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+	closesocket(sfds[WRITE]);
+	read_handle = sfds[READ];
+	break;
+      }
+    case eVIA_SHM:
+      child = shm_SPAWN(cmdargs, &ring);
+      break;
+    default:
+      child = child_SPAWN(cmdargs, _NO_FHANDLE); ASSERT(child);
+    }
+  if (stalls) handle_CLOSE(stalls_handle);
+
+  // a paced reader reads no more than 10ms worth of bytes at a time
+  int chunk_size = 1<<16;
+  if (read_rate && read_rate/100 < chunk_size)
+    chunk_size = read_rate/100 > 0 ? read_rate/100 : 1;
+  uint64_t read_start = clock_NS();
+  long long got = 0, reads = 0, syscalls = 0;
+  if (ring)
+    {
+      char* chunk = malloc(chunk_size); ASSERT(chunk);
+      for (;;)
+	{
+	  if (read_rate) pace_WAIT(read_start, got, read_rate);
+	  int read = shm_READ(ring, chunk, chunk_size);
+	  if (read <= 0) break;
+	  got += read; reads++;
+	  _KICK();
+	}
+      free(chunk);
+      shm_CLOSE(ring, false);
+      ASSERT(got == volume);
+    }
+  else if (via != eVIA_INHERIT)
+    {
+      char* chunk = malloc(chunk_size); ASSERT(chunk);
+      struct READER rd;
+      reader_OPEN(&rd, reader, read_handle, sock);
+      for (;;)
+	{
+	  if (read_rate) pace_WAIT(read_start, got, read_rate);
+	  int read = reader_READ(&rd, chunk, chunk_size);
+	  if (read <= 0) break;
+	  got += read; reads++;
+	  _KICK();
+	}
+      syscalls = rd.syscalls;
+      reader_CLOSE(&rd);
+      free(chunk);
+      if (sock) closesocket((SOCKET)read_handle); else _close((int)read_handle);
+      ASSERT(got == volume);
+    }
+
+  struct CHILD_STATS stats;
+  child_REAP(child, &stats);
+  uint64_t elapsed = clock_NS()-start, cpu = cpu_NS()-cpu_start;
+
+  // the sizes of a pipe only
+  char pipe_args[48] = "";
+  if (via == eVIA_PIPE)
+    snprintf(pipe_args, sizeof(pipe_args), " :pipe-size %d :pipe-capacity %d",
+	     pipe_size, capacity);
+  RPT(":throughput :transport %s :reader %s%s :stream %s"
+      " :mode %s :mbytes %.1f :mb-per-s %.1f :bytes-per-write %.1f :bytes-per-read %.1f"
+      " :reader-syscalls-per-mb %.1f :parent-cpu-ms %.1f :child-cpu-ms %.1f\n",
+      via==eVIA_PIPE ? "pipe" : sock ? "sock" : via==eVIA_PTY ? "pty"
+      : via==eVIA_SHM ? "shm" : "inherit",
+      via == eVIA_SHM ? "n/a" : reader_NAME(reader), pipe_args,
+      via == eVIA_SHM ? "shm" : stream_NAME(stream),
+      via == eVIA_SHM ? "n/a" : mode ? mode_args+1 : "default",
+      volume/1048576.0, volume/1048576.0/(elapsed/1e9),
+      stats.write_syscalls > 0 ? (double)volume/stats.write_syscalls : 0.0,
+      reads ? (double)got/reads : 0.0, syscalls/(volume/1048576.0),
+      cpu/1e6, stats.cpu_ns/1e6);
+  if (stalls)
+    {
+      RPT(":stalls :read-rate %d :pace %d :writes %llu :blocked-ms %.1f :blocked-share %.1f%%\n",
+	  read_rate, pace, (unsigned long long)stalls->hist.total, stalls->blocked_ns/1e6,
+	  100.0*stalls->blocked_ns/elapsed);
+      hist_RPT(&stalls->hist, "stall");
+      stalls_CLOSE(stalls);
+    }
+}
+
+#ifdef _WIN32
+void splice_BENCH(int mbytes, int write_count, bool vmsplice, enum e_args forward,
+		  bool to_file, bool to_sock)
+{
+  (void) mbytes; (void) write_count; (void) vmsplice; (void) forward;
+  (void) to_file; (void) to_sock;
+  RPT(":bench-splice :unsupported-on-this-platform\n");
+}
+#else
+static void* sock_DRAIN(void* _sock)
+/* Read and discard everything arriving at socket _SOCK until the peer
+   shuts down. */
+{
+  SOCKET sock = (SOCKET)(intptr_t)_sock;
+  char chunk[1<<16];
+  while (recv(sock, chunk, sizeof(chunk), 0) > 0) continue;
+  return 0;
+}
+
+static void splice_ALL(int in, int out, int len)
+/* Move LEN bytes from IN to OUT, at least one of which is a pipe. */
+{
+  while (len > 0)
+    {
+      ssize_t moved = splice(in, NULL, out, NULL, len, SPLICE_F_MOVE);
+      ASSERT( moved > 0 );
+      len -= moved;
+    }
+}
+
+static void write_ALL(int out, char const * buf, int len)
+/* Write LEN bytes of BUF to OUT. */
+{
+  while (len > 0)
+    {
+      int wrote = _write(out, buf, len);
+      ASSERT( wrote > 0 );
+      buf += wrote; len -= wrote;
+    }
+}
+
+void splice_BENCH(int mbytes, int write_count, bool vmsplice, enum e_args forward,
+		  bool to_file, bool to_sock)
+/* Spawn a child process that writes MBYTES of '$' characters to its
+   stderr, redirected to a _pipe(), in chunks of WRITE-COUNT characters
+   with fwrite() to the unbuffered stream or, when VMSPLICE is set,
+   with vmsplice().
+
+   The parent forwards everything it receives to a temporary file
+   (TO-FILE), to a socket drained by a thread (TO-SOCK) or to both. The
+   FORWARD-ing is done by copying through a buffer with read() and
+   write() (`eREAD'), or by splice()ing from the pipe (`eBENCH_SPLICE'),
+   in which case the data reach both destinations by tee()ing it to a
+   second pipe first.
+
+   Reports the throughput and the CPU time of the parent, including the
+   draining thread, and the child.
+*/
+{
+  long long repeat = (((long long)mbytes<<20) + write_count-1) / write_count;
+  ASSERT(repeat <= INT_MAX);
+  long long volume = repeat * write_count;
+
+  char cmdargs[64];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs),
+			      ":to-stderr :quiet :repeat %lld%s :write %d :unbuf",
+			      repeat, vmsplice ? " :vmsplice" : "", write_count);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+
+  enum { READ, WRITE };
+  int file = -1;
+  if (to_file)
+    {
+      char path[] = "/tmp/stest-splice-XXXXXX";
+      file = mkstemp(path);
+      ASSERT( file != -1 );
+      unlink(path);
+    }
+  SOCKET sfds[2] = { INVALID_SOCKET, INVALID_SOCKET };
+  pthread_t drain;
+  if (to_sock)
+    {
+      socket_PAIR(sfds);
+      int rc = pthread_create(&drain, NULL, sock_DRAIN, (void*)(intptr_t)sfds[READ]);
+      ASSERT( rc == 0 );
+    }
+  int tfds[2] = { -1, -1 };
+  if (forward != eREAD && to_file && to_sock)
+    {
+      int rc = pipe_OPEN (tfds, 0);
+      ASSERT( rc == 0 );
+    }
+
+  uint64_t cpu_start = cpu_NS(), start = clock_NS();
+  int pfds[2];
+  int rc = pipe_OPEN (pfds, 0);
+  ASSERT( rc == 0 );
+  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+  child_t child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+  handle_CLOSE(write_handle);
+
+  int const chunk_size = 1<<16;
+  char* chunk = forward == eREAD ? malloc(chunk_size) : NULL;
+  long long got = 0;
+  for (;;)
+    {
+      int moved;
+      if (forward == eREAD)
+	{
+	  moved = _read(pfds[READ], chunk, chunk_size);
+	  if (moved <= 0) break;
+	  if (to_file) write_ALL(file, chunk, moved);
+	  if (to_sock) write_ALL(sfds[WRITE], chunk, moved);
+	}
+      else if (to_file && to_sock)
+	{
+	  // wait for data, tee() returns 0 only when it is all in
+	  struct pollfd pfd = { pfds[READ], POLLIN, 0 };
+	  poll(&pfd, 1, -1);
+	  moved = tee(pfds[READ], tfds[WRITE], chunk_size, 0);
+	  if (moved <= 0) break;
+	  splice_ALL(pfds[READ], file, moved);
+	  splice_ALL(tfds[READ], sfds[WRITE], moved);
+	}
+      else
+	{
+	  moved = splice(pfds[READ], NULL, to_file ? file : sfds[WRITE], NULL,
+			 chunk_size, SPLICE_F_MOVE);
+	  if (moved <= 0) break;
+	}
+      got += moved;
+      _KICK();
+    }
+  ASSERT(got == volume);
+  free(chunk);
+  _close(pfds[READ]);
+
+  if (to_sock)
+    {
+      shutdown(sfds[WRITE], SHUT_WR);
+      pthread_join(drain, NULL);
+      closesocket(sfds[READ]); closesocket(sfds[WRITE]);
+    }
+  if (to_file)
+    {
+      ASSERT( lseek(file, 0, SEEK_END) == volume );
+      _close(file);
+    }
+  if (tfds[READ] != -1) { _close(tfds[READ]); _close(tfds[WRITE]); }
+
+  struct CHILD_STATS stats;
+  child_REAP(child, &stats);
+  uint64_t elapsed = clock_NS()-start, cpu = cpu_NS()-cpu_start;
+
+  RPT(":splice :writer %s :forward %s :to %s"
+      " :mbytes %.1f :mb-per-s %.1f :parent-cpu-ms %.1f :child-cpu-ms %.1f\n",
+      vmsplice ? "vmsplice" : "fwrite", forward == eREAD ? "copy" : "splice",
+      to_file && to_sock ? "file+sock" : to_file ? "file" : "sock",
+      volume/1048576.0, volume/1048576.0/(elapsed/1e9), cpu/1e6, stats.cpu_ns/1e6);
+}
+#endif
+
+
+
+bool writer_PARSE(int const args[], int* at, bool latency,
+		  int* threads, int* thread_buffer, enum e_args* stream)
+/* Validate the options of how the stderr of a :to-stderr process is
+   written to, starting at ARGS[*AT], i.e. the :writer-threads T RCOUNT
+   [:thread-buffer BYTES] and the :stream KIND or :write-api API
+   CALL-BYTES, if any, and place those in THREADS, THREAD-BUFFER and
+   STREAM. LATENCY is set when the records are timestamps, which the
+   threads do not write.
+
+   Moves *AT on to the argument past them, or to the invalid one and
+   returns false. */
+{
+  int x = *at;
+#define _INVALID() { *at = x; return false; }
+  if (args[x] == eWRITER_THREADS)
+    {
+      /* T RCOUNT [:thread-buffer BYTES] */
+      if (latency) _INVALID();
+      if (++x > args[0]) _INVALID();
+      if (args[x] <= 0 || args[x] > _WRITER_THREADS_MAX) _INVALID();
+      *threads = args[x];
+      if (++x > args[0]) _INVALID();
+      if (args[x] <= 0) _INVALID();
+      if (++x > args[0]) _INVALID();
+      if (args[x] == eTHREAD_BUFFER)
+	{
+	  if (++x > args[0]) _INVALID();
+	  if (args[x] <= 0) _INVALID();
+	  *thread_buffer = args[x];
+	  if (++x > args[0]) _INVALID();
+	}
+    }
+  if (args[x] == eSTREAM)
+    {
+      /* KIND */
+      if (++x > args[0]) _INVALID();
+      if (args[x] < eSTREAM_CERR || args[x] > eSTREAM_WRITE2) _INVALID();
+      *stream = args[x];
+      // the iostreams are not shared by threads, and write2 has no
+      // buffer to hand them
+      if (*threads && *stream != eSTREAM_FWRITE
+	  && (*stream != eSTREAM_WRITE2 || *thread_buffer)) _INVALID();
+      if (++x > args[0]) _INVALID();
+    }
+  if (args[x] == eWRITE_API && !*stream && !*threads)
+    {
+      /* API CALL-BYTES */
+      if (++x > args[0]) _INVALID();
+      *stream = args[x];
+      if (++x > args[0]) _INVALID();
+      if (!api_OK(*stream, args[x])) _INVALID();
+      if (++x > args[0]) _INVALID();
+    }
+#undef _INVALID
+  *at = x;
+  return true;
+}
+
+int writer_SKIP(int const args[], int at, int* threads)
+/* Return the index of the last of the options `writer_PARSE' takes
+   that follow ARGS[AT], AT if none, and place the T of
+   :writer-threads in THREADS, 0 if not given. */
+{
+  *threads = args[at+1]==eWRITER_THREADS ? args[at+2] : 0;
+  if (*threads) at += args[at+4]==eTHREAD_BUFFER ? 5 : 3;
+  return at + (args[at+1]==eSTREAM ? 2 : args[at+1]==eWRITE_API ? 3 : 0);
+}
+
+
+bool args_PARSE(int argc, char const * argv[], int args[])
+/* Parse ARGC number of arguments from ARGV, and on success place
+   results in ARGS. First entry of ARGV is program name/path. ARGS
+   must have enough space to accommodate ARGC number of entries.
+
+   The arguments are parsed according to the descriptions in `usage'
+   global variable.
+
+   The first entry in ARGS is the count of arguments succesfully parsed. 
+
+   Each other entry can be
+   1. an e_args command or identifier, or
+   2. an integer number
+
+   It prints out `usage' in case of no arguments provided, or an error
+   with an indicator/description where the parsing has gone wrong.
+
+   It returns true on success, false otherwise.
+*/
+{
+  assert(e_E-e_S == sizeof(usage)/sizeof(char*));
+    
+  memset(args, 0, sizeof(int)*argc);
+  
+  int c = 0;
+  if (argc > 1)
+    {
+      for (int v=1;v<argc;v++)
+	{
+	  args[++c] = strtol(argv[v], NULL, 10);
+	  assert(args[c]>e_I && "negative integer arg overlaps with reserved enum range");
+	  if (args[c] < e_I
+	      || (args[c] == 0 && strcmp("0", argv[v])))
+	    {
+	      enum e_args e = args[c] =
+		!strcmp(":to-stderr"           , argv[v]) ? eTO_STDERR            :
+		!strcmp(":to-child-stderr"     , argv[v]) ? eTO_CHILD_STDERR      :
+		!strcmp(":pipe"                , argv[v]) ? ePIPE                 :
+		!strcmp(":pipe-handle-to-child", argv[v]) ? ePIPE_HANDLE_TO_CHILD :
+		!strcmp(":to-handle"           , argv[v]) ? eTO_HANDLE            :
+		!strcmp(":pipe-to-child-stderr", argv[v]) ? ePIPE_TO_CHILD_STDERR :
+		!strcmp(":sock-to-child-stderr", argv[v]) ? eSOCK_TO_CHILD_STDERR :
+		!strcmp(":pty-to-child-stderr" , argv[v]) ? ePTY_TO_CHILD_STDERR  :
+		!strcmp(":shm-to-child"        , argv[v]) ? eSHM_TO_CHILD         :
+		!strcmp(":shm"                 , argv[v]) ? eSHM                  :
+		!strcmp("shm"                  , argv[v]) ? eVIA_SHM              :
+		!strcmp(":write"               , argv[v]) ? eWRITE                :
+		!strcmp(":write-nl"            , argv[v]) ? eWRITE_NL             :
+		!strcmp(":pipe-size"           , argv[v]) ? ePIPE_SIZE            :
+		!strcmp(":read"                , argv[v]) ? eREAD                 :
+		!strcmp(":latency"             , argv[v]) ? eLATENCY              :
+		!strcmp(":stamp"               , argv[v]) ? eSTAMP                :
+		!strcmp(":quiet"               , argv[v]) ? eQUIET                :
+		!strcmp(":repeat"              , argv[v]) ? eREPEAT               :
+		!strcmp(":bench-throughput"    , argv[v]) ? eBENCH_THROUGHPUT     :
+		!strcmp(":transport"           , argv[v]) ? eTRANSPORT            :
+		!strcmp("pipe"                 , argv[v]) ? eVIA_PIPE             :
+		!strcmp("sock"                 , argv[v]) ? eVIA_SOCK             :
+		!strcmp("pty"                  , argv[v]) ? eVIA_PTY              :
+		!strcmp("inherit"              , argv[v]) ? eVIA_INHERIT          :
+		!strcmp(":sweep"               , argv[v]) ? eSWEEP                :
+		!strcmp(":default"             , argv[v]) ? eDEFAULT              :
+		!strcmp(":jobs"                , argv[v]) ? eJOBS                 :
+		!strcmp(":csv"                 , argv[v]) ? eCSV                  :
+		!strcmp(":json"                , argv[v]) ? eJSON                 :
+		!strcmp(":bench-splice"        , argv[v]) ? eBENCH_SPLICE         :
+		!strcmp(":vmsplice"            , argv[v]) ? eVMSPLICE             :
+		!strcmp(":fanin-children"      , argv[v]) ? eFANIN_CHILDREN       :
+		!strcmp(":probe-pipe-capacity" , argv[v]) ? ePROBE_PIPE_CAPACITY  :
+		!strcmp(":probe-stdio-buffer"  , argv[v]) ? ePROBE_STDIO_BUFFER   :
+		!strcmp("file"                 , argv[v]) ? eVIA_FILE             :
+		!strcmp(":stdout"              , argv[v]) ? eSTDOUT               :
+		!strcmp(":hold"                , argv[v]) ? eHOLD                 :
+		!strcmp(":verify-stream"       , argv[v]) ? eVERIFY_STREAM        :
+		!strcmp(":records"             , argv[v]) ? eRECORDS              :
+		!strcmp(":bench-spawn"         , argv[v]) ? eBENCH_SPAWN          :
+		!strcmp(":trace-to-json"       , argv[v]) ? eTRACE_TO_JSON        :
+		!strcmp(":rss"                 , argv[v]) ? eRSS                  :
+		!strcmp(":spawner"             , argv[v]) ? eSPAWNER              :
+		!strcmp("fork"                 , argv[v]) ? eSPAWN_FORK           :
+		!strcmp("vfork"                , argv[v]) ? eSPAWN_VFORK          :
+		!strcmp("posix-spawn"          , argv[v]) ? eSPAWN_POSIX          :
+		!strcmp("clone"                , argv[v]) ? eSPAWN_CLONE          :
+		!strcmp(":pool"                , argv[v]) ? ePOOL                 :
+		!strcmp(":bench-socket"        , argv[v]) ? eBENCH_SOCKET         :
+		!strcmp(":socket"              , argv[v]) ? eSOCKET               :
+		!strcmp("pair"                 , argv[v]) ? eSOCK_PAIR            :
+		!strcmp("unix"                 , argv[v]) ? eSOCK_UNIX            :
+		!strcmp("seqpacket"            , argv[v]) ? eSOCK_SEQPACKET       :
+		!strcmp("tcp"                  , argv[v]) ? eSOCK_TCP             :
+		!strcmp(":sndbuf"              , argv[v]) ? eSNDBUF               :
+		!strcmp(":rcvbuf"              , argv[v]) ? eRCVBUF               :
+		!strcmp(":nodelay"             , argv[v]) ? eNODELAY              :
+		!strcmp(":cork"                , argv[v]) ? eCORK                 :
+		!strcmp(":zerocopy"            , argv[v]) ? eZEROCOPY             :
+		!strcmp(":read-rate"           , argv[v]) ? eREAD_RATE            :
+		!strcmp(":pace"                , argv[v]) ? ePACE                 :
+		!strcmp(":stalls"              , argv[v]) ? eSTALLS               :
+		!strcmp(":reader"              , argv[v]) ? eREADER               :
+		!strcmp(":trace-child"         , argv[v]) ? eTRACE_CHILD          :
+		!strcmp("blocking"             , argv[v]) ? eREAD_BLOCKING        :
+		!strcmp("epoll"                , argv[v]) ? eREAD_EPOLL           :
+		!strcmp("uring"                , argv[v]) ? eREAD_URING           :
+		!strcmp(":preload"             , argv[v]) ? ePRELOAD              :
+		!strcmp("unbuf"                , argv[v]) ? ePOLICY_UNBUF         :
+		!strcmp("lnbuf"                , argv[v]) ? ePOLICY_LNBUF         :
+		!strcmp("bytes"                , argv[v]) ? ePOLICY_BYTES         :
+		!strcmp("us"                   , argv[v]) ? ePOLICY_US            :
+		!strcmp(":unbuf"               , argv[v]) ? eUNBUF                :
+		!strcmp(":lnbuf"               , argv[v]) ? eLNBUF                :
+		!strcmp(":flbuf"               , argv[v]) ? eFLBUF                :
+		!strcmp(":adaptive"            , argv[v]) ? eADAPTIVE             :
+		!strcmp(":stream"              , argv[v]) ? eSTREAM               :
+		!strcmp("cerr"                 , argv[v]) ? eSTREAM_CERR          :
+		!strcmp("clog"                 , argv[v]) ? eSTREAM_CLOG          :
+		!strcmp("fwrite"               , argv[v]) ? eSTREAM_FWRITE        :
+		!strcmp("write2"               , argv[v]) ? eSTREAM_WRITE2        :
+		!strcmp(":write-api"           , argv[v]) ? eWRITE_API            :
+		!strcmp("fputc"                , argv[v]) ? eAPI_FPUTC            :
+		!strcmp("fputs"                , argv[v]) ? eAPI_FPUTS            :
+		!strcmp("fprintf"              , argv[v]) ? eAPI_FPRINTF          :
+		!strcmp("fwrite-unlocked"      , argv[v]) ? eAPI_FWRITE_UNLOCKED  :
+		!strcmp("writev"               , argv[v]) ? eAPI_WRITEV           :
+		!strcmp(":writer-threads"      , argv[v]) ? eWRITER_THREADS       :
+		!strcmp(":thread-buffer"       , argv[v]) ? eTHREAD_BUFFER        :
+		e_S;
+
+	      if (e==e_S) break;
+	    }
+	};
+    }
+  args[0] = c;
+  
+#define _USAGE() {printf("usage: %s [:deadline-ms MS] [:trace FILE] COMMANDS\n\n%s\n\ncommands:\n",argv[0],usage[0]); \
+                  for(int i=1;i<e_E-e_S;i++){printf("  %s\n\n",usage[i]);}return false;}
+  if (!args[0]) _USAGE();
+
+  
+  int x = 1;
+#define _OPTIONS(C) {printf("%s",argv[0]);for(int i=1;i<x;i++)printf(" %s",argv[i]);\
+                     printf(" ::error::\n\noptions:\n\t%s\t\n",usage[C-e_S]); return false;}
+  enum e_args cmd = args[x];
+  switch (cmd)
+    {
+    case ePIPE_TO_CHILD_STDERR: case eSOCK_TO_CHILD_STDERR:
+    case ePTY_TO_CHILD_STDERR: case eBENCH_THROUGHPUT:
+      if (x < args[0] && args[x+1] == ePOOL)
+	{
+	  /* WORKERS */
+	  ++x;
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  break;
+	}
+      if (cmd == eBENCH_THROUGHPUT) break;
+      // fall through
+    case eTO_CHILD_STDERR:
+      if (x < args[0] && args[x+1] == eTRACE_CHILD) ++x;
+      break;
+    default: break;
+    }
+  switch (cmd)
+    {
+    case ePIPE_HANDLE_TO_CHILD: case ePIPE_TO_CHILD_STDERR:
+    case eSOCK_TO_CHILD_STDERR: case ePTY_TO_CHILD_STDERR:
+    case eBENCH_THROUGHPUT: case eVERIFY_STREAM:
+      if (x < args[0] && args[x+1] == eREADER)
+	{
+	  /* READER... */
+	  ++x;
+	  do
+	    {
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] < eREAD_BLOCKING || args[x] > eREAD_URING) _OPTIONS(cmd);
+	    }
+	  while ((cmd == eBENCH_THROUGHPUT || cmd == eVERIFY_STREAM) && x < args[0]
+		 && args[x+1] >= eREAD_BLOCKING && args[x+1] <= eREAD_URING);
+	}
+      break;
+    default: break;
+    }
+  enum e_args stream = 0; /* the :stream KIND given, if any */
+  int threads = 0, thread_buffer = 0; /* of :writer-threads */
+  switch (cmd)
+    {
+    case eTO_STDERR: case eTO_CHILD_STDERR:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (cmd == eTO_STDERR)
+	{
+	  if (args[x] == eQUIET && ++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] == eSHM)
+	    {
+	      /* HANDLE */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] < 0) _OPTIONS(cmd);
+	      if (++x > args[0]) _OPTIONS(cmd);
+	    }
+	  if (args[x] == eSTAMP && ++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] == eREPEAT)
+	    {
+	      /* REPEAT-COUNT */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] <= 0) _OPTIONS(cmd);
+	      if (++x > args[0]) _OPTIONS(cmd);
+	    }
+	  if (args[x] == eVMSPLICE && ++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] == eSTDOUT && ++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] == eHOLD)
+	    {
+	      /* MS */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] <= 0) _OPTIONS(cmd);
+	      if (++x > args[0]) _OPTIONS(cmd);
+	    }
+	  if (args[x] == ePACE)
+	    {
+	      /* BYTES-PER-S */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] <= 0) _OPTIONS(cmd);
+	      if (++x > args[0]) _OPTIONS(cmd);
+	    }
+	  if (args[x] == eSTALLS)
+	    {
+	      /* HANDLE */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] < 0) _OPTIONS(cmd);
+	      if (++x > args[0]) _OPTIONS(cmd);
+	    }
+	}
+      if (!writer_PARSE(args, &x, false, &threads, &thread_buffer, &stream)) _OPTIONS(cmd);
+      switch (args[x])
+	{
+	case eWRITE: case eWRITE_NL:
+	  /* WRITE-COUNT */
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  break;
+	case eRECORDS:
+	  if (stream || threads) _OPTIONS(cmd);
+	  /* RECORD-LEN RECORD-COUNT */
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < _RECORD_MIN || args[x] % 8) _OPTIONS(cmd);
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  if (x < args[0]) _OPTIONS(cmd);
+	  break;
+	default: _OPTIONS(cmd);
+	}
+      bool adaptive = x < args[0] && args[x+1] == eADAPTIVE;
+      if (x < args[0] && args[x+1] != ePRELOAD && !stream_MODE_OK(stream, args[x+1]))
+	_OPTIONS(cmd);
+      if (x < args[0] && args[x+1] != ePRELOAD) switch(args[++x])
+			 {
+			 case eUNBUF: break;
+			 case eADAPTIVE:
+			   /* MAXDELAY-US */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 0) _OPTIONS(cmd);
+			   // fall through
+			 case eLNBUF: case eFLBUF:
+			   /* BUFFER-SIZE */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 1) _OPTIONS(cmd);
+			   break;
+			 default: _OPTIONS(cmd);
+			 }
+      if (cmd == eTO_CHILD_STDERR && x < args[0])
+	{
+	  // the shim has no say over an :adaptive stream, or one that is
+	  // not stdio's
+	  if (args[++x] != ePRELOAD || adaptive || stream || threads) _OPTIONS(cmd);
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  switch (args[x])
+	    {
+	    case ePOLICY_UNBUF: case ePOLICY_LNBUF: break;
+	    case ePOLICY_BYTES: case ePOLICY_US:
+	      /* N or T */
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] <= 0) _OPTIONS(cmd);
+	      break;
+	    default: _OPTIONS(cmd);
+	    }
+	  /* RUNS MBYTES */
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	}
+      break;
+    case ePIPE: case ePIPE_HANDLE_TO_CHILD:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != ePIPE_SIZE) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < 0) _OPTIONS(cmd);      
+      
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eREAD) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < 0) _OPTIONS(cmd);      
+
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eWRITE) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);      
+      break;
+    case eTO_HANDLE:
+      /* HANDLE */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < 0) _OPTIONS(cmd);      
+      /* WRITE-COUNT */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < 0) _OPTIONS(cmd);      
+      break;
+    case ePIPE_TO_CHILD_STDERR:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != ePIPE_SIZE) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < 0) _OPTIONS(cmd);      
+
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eREAD && args[x] != eLATENCY) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < (args[x-1] == eLATENCY)) _OPTIONS(cmd);      
+
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (!writer_PARSE(args, &x, args[x-2] == eLATENCY, &threads, &thread_buffer, &stream))
+	_OPTIONS(cmd);
+      switch (args[x])
+	{
+	case eWRITE: case eWRITE_NL:
+	  /* WRITE-COUNT */
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  break;
+	default: _OPTIONS(cmd);
+	}
+      if (x < args[0] && !stream_MODE_OK(stream, args[x+1])) _OPTIONS(cmd);
+      if (x < args[0]) switch(args[++x])
+			 {
+			 case eUNBUF: break;
+			 case eADAPTIVE:
+			   /* MAXDELAY-US */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 0) _OPTIONS(cmd);
+			   // fall through
+			 case eLNBUF: case eFLBUF:
+			   /* BUFFER-SIZE */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 1) _OPTIONS(cmd);
+			   break;
+			 default: _OPTIONS(cmd);
+			 }
+      break;
+    case eSOCK_TO_CHILD_STDERR: case ePTY_TO_CHILD_STDERR: case eSHM_TO_CHILD:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eREAD && args[x] != eLATENCY) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < (args[x-1] == eLATENCY)) _OPTIONS(cmd);      
+
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (cmd != eSHM_TO_CHILD
+	  && !writer_PARSE(args, &x, args[x-2] == eLATENCY, &threads, &thread_buffer, &stream))
+	_OPTIONS(cmd);
+      switch (args[x])
+	{
+	case eWRITE: case eWRITE_NL:
+	  /* WRITE-COUNT */
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  break;
+	default: _OPTIONS(cmd);
+	}
+      if (x < args[0] && cmd == eSHM_TO_CHILD) _OPTIONS(cmd);
+      if (x < args[0] && !stream_MODE_OK(stream, args[x+1])) _OPTIONS(cmd);
+      if (x < args[0]) switch(args[++x])
+			 {
+			 case eUNBUF: break;
+			 case eADAPTIVE:
+			   /* MAXDELAY-US */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 0) _OPTIONS(cmd);
+			   // fall through
+			 case eLNBUF: case eFLBUF:
+			   /* BUFFER-SIZE */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 1) _OPTIONS(cmd);
+			   break;
+			 default: _OPTIONS(cmd);
+			 }
+      break;
+    case eSWEEP:
+      {
+	if (++x > args[0]) _OPTIONS(cmd);
+	if (args[x] != eTRANSPORT) _OPTIONS(cmd);
+	/* TRANSPORT... */
+	do
+	  {
+	    if (++x > args[0]) _OPTIONS(cmd);
+	    if (args[x] < eVIA_PIPE || args[x] > eVIA_INHERIT || args[x] == eVIA_SHM)
+	      _OPTIONS(cmd);
+	  }
+	while (x < args[0] && args[x+1] >= eVIA_PIPE && args[x+1] <= eVIA_INHERIT);
+	bool writes = false;
+	while (x < args[0])
+	  switch (args[++x])
+	    {
+	    case eWRITE: case eWRITE_NL: case eREAD: case ePIPE_SIZE:
+	    case eLNBUF: case eFLBUF:
+	      {
+		/* COUNT-OR-SIZE... */
+		int const min = args[x]==eREAD || args[x]==ePIPE_SIZE ? 0
+		  : args[x]==eLNBUF || args[x]==eFLBUF ? 2 : 1;
+		writes |= args[x]==eWRITE || args[x]==eWRITE_NL;
+		if (++x > args[0]) _OPTIONS(cmd);
+		if (args[x] < min) _OPTIONS(cmd);
+		while (x < args[0] && args[x+1] >= min) ++x;
+		break;
+	      }
+	    case eJOBS:
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] <= 0) _OPTIONS(cmd);
+	      break;
+	    case eDEFAULT: case eUNBUF: case eCSV: case eJSON: break;
+	    default: _OPTIONS(cmd);
+	    }
+	if (!writes) _OPTIONS(cmd);
+	break;
+      }
+    case eFANIN_CHILDREN:
+      /* N... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	}
+      while (x < args[0] && args[x+1] > 0);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eTRANSPORT) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eVIA_PIPE && args[x] != eVIA_SOCK) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eREPEAT) _OPTIONS(cmd);
+      /* REPEAT-COUNT */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eWRITE) _OPTIONS(cmd);
+      /* WRITE-COUNT */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      break;
+    case eVERIFY_STREAM:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eTRANSPORT) _OPTIONS(cmd);
+      /* TRANSPORT... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < eVIA_PIPE || args[x] > eVIA_SHM) _OPTIONS(cmd);
+	}
+      while (x < args[0] && args[x+1] < 0);
+      /* MBYTES */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eRECORDS) _OPTIONS(cmd);
+      /* RECORD-LEN */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] < _RECORD_MIN || args[x] % 8) _OPTIONS(cmd);
+      break;
+    case ePROBE_STDIO_BUFFER:
+      if (x == args[0]) break;
+      if (args[++x] != eTRANSPORT) _OPTIONS(cmd);
+      /* TRANSPORT... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  switch (args[x])
+	    {
+	    case eVIA_PIPE: case eVIA_SOCK: case eVIA_PTY: case eVIA_FILE: break;
+	    default: _OPTIONS(cmd);
+	    }
+	}
+      while (x < args[0]);
+      break;
+    case eBENCH_SOCKET:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eSOCKET) _OPTIONS(cmd);
+      /* KIND... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < eSOCK_PAIR || args[x] > eSOCK_TCP) _OPTIONS(cmd);
+	}
+      while (x < args[0] && args[x+1] >= eSOCK_PAIR && args[x+1] <= eSOCK_TCP);
+      /* RUNS MBYTES */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eWRITE) _OPTIONS(cmd);
+      /* WRITE-COUNT */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      for (int opt=eSNDBUF;opt<=eRCVBUF;opt++)
+	if (x < args[0] && args[x+1] == opt)
+	  {
+	    /* BYTES... */
+	    ++x;
+	    if (++x > args[0]) _OPTIONS(cmd);
+	    if (args[x] <= 0) _OPTIONS(cmd);
+	    while (x < args[0] && args[x+1] > 0) ++x;
+	  }
+      for (int opt=eNODELAY;opt<=eZEROCOPY;opt++)
+	if (x < args[0] && args[x+1] == opt) ++x;
+      break;
+    case eTRACE_TO_JSON:
+      break;
+    case eBENCH_SPAWN:
+      /* RUNS */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (x < args[0] && args[x+1] == eRSS)
+	{
+	  /* MBYTES... */
+	  ++x;
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < 0) _OPTIONS(cmd);
+	  while (x < args[0] && args[x+1] >= 0) ++x;
+	}
+      if (x < args[0])
+	{
+	  if (args[++x] != eSPAWNER) _OPTIONS(cmd);
+	  /* SPAWNER... */
+	  do
+	    {
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] < eSPAWN_FORK || args[x] > eSPAWN_CLONE) _OPTIONS(cmd);
+	    }
+	  while (x < args[0]);
+	}
+      break;
+    case ePROBE_PIPE_CAPACITY:
+      /* PSIZE... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < 0) _OPTIONS(cmd);
+	}
+      while (x < args[0] && args[x+1] >= 0);
+      break;
+    case eBENCH_SPLICE:
+      /* MBYTES */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eWRITE) _OPTIONS(cmd);
+      /* WRITE-COUNT */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+      break;
+    case eBENCH_THROUGHPUT:
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eTRANSPORT) _OPTIONS(cmd);
+      /* TRANSPORT... */
+      do
+	{
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] < eVIA_PIPE || args[x] > eVIA_INHERIT) _OPTIONS(cmd);
+	}
+      while (x < args[0] && args[x+1] < 0 && args[x+1] != eWRITE);
+      /* MBYTES */
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] != eWRITE) _OPTIONS(cmd);
+      if (++x > args[0]) _OPTIONS(cmd);
+      if (args[x] <= 0) _OPTIONS(cmd);
+
+      for (int opt=eREAD_RATE;opt<=ePACE;opt++)
+	if (x < args[0] && args[x+1] == opt)
+	  {
+	    // the pool's workers can not be handed the stalls' handle
+	    if (args[2] == ePOOL) _OPTIONS(cmd);
+	    /* BYTES-PER-S */
+	    ++x;
+	    if (++x > args[0]) _OPTIONS(cmd);
+	    if (args[x] <= 0) _OPTIONS(cmd);
+	  }
+
+      int streams = 0, streams_count = 0;
+      if (x < args[0] && args[x+1] == eSTREAM)
+	{
+	  /* KIND... */
+	  ++x; streams = x+1;
+	  do
+	    {
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      if (args[x] < eSTREAM_CERR || args[x] > eSTREAM_WRITE2) _OPTIONS(cmd);
+	      ++streams_count;
+	    }
+	  while (x < args[0] && args[x+1] >= eSTREAM_CERR && args[x+1] <= eSTREAM_WRITE2);
+	}
+      else if (x < args[0] && args[x+1] == eWRITE_API)
+	{
+	  /* API... CALL-BYTES */
+	  ++x; streams = x+1;
+	  do
+	    {
+	      if (++x > args[0]) _OPTIONS(cmd);
+	      ++streams_count;
+	    }
+	  while (x < args[0] && args[x+1] < 0);
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  for (int k=0;k<streams_count;k++)
+	    if (!api_OK(args[streams+k], args[x])) _OPTIONS(cmd);
+	}
+
+      if (x < args[0] && args[x+1] == ePIPE_SIZE)
+	{
+	  /* PSIZE... */
+	  ++x;
+	  if (++x > args[0]) _OPTIONS(cmd);
+	  if (args[x] <= 0) _OPTIONS(cmd);
+	  while (x < args[0] && args[x+1] > 0) ++x;
+	}
+      enum e_args mode = x < args[0] ? args[x+1] : 0;
+      if (x < args[0]) switch(args[++x])
+			 {
+			 case eUNBUF: break;
+			 case eADAPTIVE:
+			   /* MAXDELAY-US */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 0) _OPTIONS(cmd);
+			   // fall through
+			 case eLNBUF: case eFLBUF:
+			   /* BUFFER-SIZE... */
+			   if (++x > args[0]) _OPTIONS(cmd);
+			   if (args[x] <= 1) _OPTIONS(cmd);
+			   while (x < args[0] && args[x+1] > 1) ++x;
+			   break;
+			 default: _OPTIONS(cmd);
+			 }
+      for (int k=0;k<streams_count;k++)
+	if (!stream_MODE_OK(args[streams+k], mode)) _OPTIONS(cmd);
+      break;
+    default: _USAGE();
+    }
+  if (++x<=args[0])_OPTIONS(cmd);
+  
+  if (0) {printf(":args");for(int i=0;i<=c;i++){printf(" %d",args[i]);};printf("\n");};
+  return true;
+    
+}
+
+int strings_JOIN(int aistart, int total, char const * prefix,
+		 char const * argv[], char* buffer, int buffer_size)
+/* Join the strings in ARGV using space as a separator, starting from
+   AISTART index and using PREFIX as the first string. ARGV has TOTAL
+   number of entries.
+
+ The resulting string is written in BUFFER of BUFFER-SIZE.
+
+ When BUFFER is NULL or BUFFER-SIZE is 0, it returns the size of the
+ buffer required to write the result, otherwise it returns
+ BUFFER-SIZE.
+*/
+{
+  if (buffer==NULL || buffer_size==0)
+    {
+      int argc = total;
+      char const * subcmd = prefix;
+      int cmdargs_size = 1+strlen(subcmd);
+      for(int i=aistart;i<argc;i++) cmdargs_size+=1+strlen(argv[i]);
+      return cmdargs_size;      
+    }
+  else
+    {
+      int argc = total;
+      char const * subcmd = prefix;
+      char* cmdargs = buffer;
+      int cmdargs_size = buffer_size;
+      
+      memset(cmdargs,0,cmdargs_size);
+      int copied=0;
+      {
+	const int subcmd_size = strlen(subcmd);
+	assert(cmdargs_size>subcmd_size);
+	strncpy(cmdargs, subcmd, subcmd_size);
+	copied+=subcmd_size;
+      }
+      char const * separator = " ";
+      const int sep_len = strlen(separator);
+      for(int i=aistart;i<argc;i++)
+	{
+	  assert(cmdargs_size>copied+sep_len);
+	  strncat(cmdargs,separator, cmdargs_size-copied);
+	  copied+=sep_len;
+	  const int str_size = strlen(argv[i]);
+	  assert(cmdargs_size>copied+str_size);
+	  strncat(cmdargs,argv[i],cmdargs_size-copied);
+	  copied+=str_size;
+	}
+      assert(copied==cmdargs_size-1);
+      return cmdargs_size;
+    }
+}
+
+uint64_t clock_NS(void)
+/* Return the system wide monotonic time in ns, comparable between
+   processes. */
+{
+#ifdef _WIN32
+  static LARGE_INTEGER freq;
+  if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000
+    + (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+void stamp_SET(char* msg)
+/* Overwrite the first _STAMP_LEN chars of MSG with the current
+   monotonic time. */
+{
+  char stamp[_STAMP_LEN+1];
+  snprintf(stamp, sizeof(stamp), "@%0*llu", _STAMP_LEN-1,
+	   (unsigned long long)clock_NS());
+  memcpy(msg, stamp, _STAMP_LEN);
+}
+
+void pace_WAIT(uint64_t start, long long done, int rate)
+/* Sleep until the DONE bytes moved since START (see `clock_NS') are
+   no more than the RATE in bytes per second allows. */
+{
+  uint64_t due = start + (uint64_t)(done * 1e9 / rate);
+  uint64_t now = clock_NS();
+  if (now >= due) return;
+#ifdef _WIN32
+  Sleep((due-now)/1000000);
+#else
+  struct timespec ts = { (due-now)/1000000000, (due-now)%1000000000 };
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) continue;
+#endif
+}
+
+void stalls_ADD(struct STALLS* stalls, uint64_t ns)
+{
+  hist_ADD(&stalls->hist, ns);
+  stalls->blocked_ns += ns;
+}
+
+static int hist_INDEX(uint64_t ns)
+/* Return the index of the HISTOGRAM bucket NS falls into. Values below
+   2*_HIST_SUB have a bucket of their own. */
+{
+  if (ns < 2*_HIST_SUB) return ns;
+  int shift = 63-__builtin_clzll(ns)-_HIST_SUB_BITS;
+  return shift*_HIST_SUB + (ns>>shift);
+}
+
+static uint64_t hist_LOW(int index)
+/* Return the lowest value of bucket INDEX, the bucket spans up to
+   (excluding) the lowest value of INDEX+1. */
+{
+  if (index < 2*_HIST_SUB) return index;
+  int shift = index/_HIST_SUB-1;
+  return (uint64_t)(index%_HIST_SUB+_HIST_SUB) << shift;
+}
+
+void hist_ADD(struct HISTOGRAM* hist, uint64_t ns)
+{
+  hist->counts[hist_INDEX(ns)]++;
+  if (!hist->total || ns < hist->min) hist->min = ns;
+  if (ns > hist->max) hist->max = ns;
+  hist->total++;
+}
+
+uint64_t hist_PERCENTILE(struct HISTOGRAM const * hist, double percent)
+/* Return the highest value equivalent to the PERCENT percentile of
+   HIST, that is the top of the bucket it falls into. */
+{
+  uint64_t rank = (uint64_t)(percent/100*hist->total+0.5);
+  if (rank < 1) rank = 1;
+  uint64_t seen = 0;
+  int buckets = sizeof(hist->counts)/sizeof(hist->counts[0]);
+  for (int i=0;i<buckets;i++)
+    {
+      seen += hist->counts[i];
+      if (seen >= rank)
+	{
+	  uint64_t top = hist_LOW(i+1)-1;
+	  return top < hist->max ? top : hist->max;
+	}
+    }
+  return hist->max;
+}
+
+void hist_RPT(struct HISTOGRAM const * hist, char const * name)
+/* Report the percentiles of HIST followed by its non empty buckets, all
+   in us, under NAME. */
+{
+  if (!hist->total) { RPT(":%s-us :count 0\n", name); return; }
+
+  RPT(":%s-us :count %llu :min %.3f :p50 %.3f :p90 %.3f :p99 %.3f :max %.3f\n",
+      name, (unsigned long long)hist->total, hist->min/1e3,
+      hist_PERCENTILE(hist, 50)/1e3, hist_PERCENTILE(hist, 90)/1e3,
+      hist_PERCENTILE(hist, 99)/1e3, hist->max/1e3);
+
+  uint64_t most = 0;
+  int buckets = sizeof(hist->counts)/sizeof(hist->counts[0]);
+  for (int i=0;i<buckets;i++) if (hist->counts[i] > most) most = hist->counts[i];
+  for (int i=0;i<buckets;i++)
+    {
+      if (!hist->counts[i]) continue;
+      char bar[41]; int bar_len = (int)(40*hist->counts[i]/most);
+      memset(bar, '#', bar_len); bar[bar_len] = 0;
+      RPT(":%s-bucket-us [%.3f,%.3f) %llu %s\n", name,
+	  hist_LOW(i)/1e3, hist_LOW(i+1)/1e3,
+	  (unsigned long long)hist->counts[i], bar);
+    }
+}
+
+static void watchdog_KILL(void)
+/* Terminate the process from the watchdog thread, with _exit(), since
+   exit() would flush the stdio streams and wait forever for the lock of
+   the one the main thread is stuck writing to. The parent's own exit
+   handlers that do not touch those streams run first. */
+{
+#ifndef _WIN32
+  if (_RL[0] == 'P')
+    {
+      _LOG_DUMP();
+      mx_UNLINK();
+    }
+#endif
+  _exit(99);
+}
+
+#ifdef _WIN32
+DWORD _EXIT(LPVOID _exit_us)
+/* Exit the program unless there was some `_KICK'ed activity within
+   the last _EXIT_US microseconds, checked at that period. */
+{
+  int exit_ms = (*(int*)_exit_us+999)/1000;
+  uint64_t seen;
+  do
+    {
+      seen = __atomic_load_n(&_ACTIVITY, __ATOMIC_RELAXED);
+      Sleep(exit_ms);
+    }
+  while (seen != __atomic_load_n(&_ACTIVITY, __ATOMIC_RELAXED));
+  RPT(_KILLED "secs %d\n", exit_ms/1000);
+  watchdog_KILL();
+  return 0;
+}
+#else
+void* _EXIT(void* _exit_us)
+/* Exit the program unless there was some `_KICK'ed activity, progress
+   of the `_BLOCKED' operation or readiness of its handle within the
+   last _EXIT_US microseconds, reporting the operation it was stuck in.
+
+   A timerfd armed at the deadline of the last activity, the handle of
+   the operation and the eventfd `_WAKE_FD' wait together on epoll, so
+   that the process is stopped as soon as the deadline passes, rather
+   than up to twice its length later as with periodic checks. The
+   deadline runs from the time the activity was stamped at, not from
+   the time the watchdog noticed it. The handle is watched one shot
+   for the readiness the operation waits for, which is then taken as
+   activity once for each offset, lest a stale operation on a handle
+   that stays ready keep a stuck process alive.
+*/
+{
+  uint64_t deadline_ns = (uint64_t)*(int*)_exit_us * 1000;
+  int epfd = epoll_create1(EPOLL_CLOEXEC); ASSERT( epfd != -1 );
+  int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC); ASSERT( tfd != -1 );
+  struct epoll_event event = { .events = EPOLLIN, .data.fd = tfd };
+  int rc = epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &event); ASSERT( rc == 0 );
+  int wake = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK); ASSERT( wake != -1 );
+  event.data.fd = wake;
+  rc = epoll_ctl(epfd, EPOLL_CTL_ADD, wake, &event); ASSERT( rc == 0 );
+  __atomic_store_n(&_WAKE_FD, wake, __ATOMIC_RELAXED);
+
+  uint64_t last = clock_NS(), now = last;
+  long long offset = -1;
+  int watched = -1; bool granted = false;
+  for (;;)
+    {
+      long long at = __atomic_load_n(&_BLOCKED.offset, __ATOMIC_ACQUIRE);
+      uint64_t kicked = __atomic_load_n(&_ACTIVITY, __ATOMIC_RELAXED);
+      if (kicked > last) last = kicked;
+      now = clock_NS();
+      if (at != offset) { offset = at; granted = false; }
+      if (now - last >= deadline_ns) break;
+
+      // the handle may have been closed, or its number reused, since
+      if (watched != -1) epoll_ctl(epfd, EPOLL_CTL_DEL, watched, NULL);
+      watched = __atomic_load_n(&_BLOCKED.fd, __ATOMIC_ACQUIRE);
+      struct epoll_event ready = {
+	.events = (__atomic_load_n(&_BLOCKED.writing, __ATOMIC_RELAXED) ? EPOLLOUT : EPOLLIN)
+	| EPOLLONESHOT,
+	.data.fd = watched };
+      if (granted || watched == -1 || epoll_ctl(epfd, EPOLL_CTL_ADD, watched, &ready))
+	watched = -1;
+
+      uint64_t due = last + deadline_ns;
+      struct itimerspec its = { { 0, 0 }, { due/1000000000, due%1000000000 } };
+      rc = timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL); ASSERT( rc == 0 );
+
+      struct epoll_event events[3];
+      int count = epoll_wait(epfd, events, 3, -1);
+      ASSERT( count != -1 || errno == EINTR );
+      for (int e=0;e<count;e++)
+	if (events[e].data.fd == tfd || events[e].data.fd == wake)
+	  {
+	    uint64_t expirations;
+	    ssize_t got = read(events[e].data.fd, &expirations, sizeof(expirations)); (void)got;
+	  }
+	else if (!granted) { last = clock_NS(); granted = true; }
+    }
+
+  char const * op = __atomic_load_n(&_BLOCKED.op, __ATOMIC_RELAXED);
+  int fd = __atomic_load_n(&_BLOCKED.fd, __ATOMIC_RELAXED);
+  bool writing = __atomic_load_n(&_BLOCKED.writing, __ATOMIC_RELAXED);
+  struct pollfd pfd = { fd, writing ? POLLOUT : POLLIN, 0 };
+  int queued = -1;
+  if (fd == -1 || ioctl(fd, FIONREAD, &queued) == -1) queued = -1;
+  RPT(_KILLED "ms %.3f :blocked-in %s :fd %d :offset %lld"
+      " :ready %s :queued %d\n", (now-last)/1e6, op ? op : "unknown", fd, offset,
+      fd == -1 ? "unknown" : poll(&pfd, 1, 0) == 1 ? "yes" : "no", queued);
+  watchdog_KILL();
+  return NULL;
+}
+#endif
+
+#ifndef _WIN32
+
+void mx_UNLINK(void)
+/* Remove the name of the logging synchronization mutex. */
+{
+  shm_unlink(_MX_ID);
+}
+
+bool log_RECORD(bool cmd, char const * fs, ...)
+/* Record the commentary line formatted from FS and its arguments as
+   the next event of this process' ring, a CMD line when CMD is set.
+   Return false, leaving it to the caller to print it, when the ring is
+   full.
+*/
+{
+  uint64_t ns = clock_NS();
+  uint32_t i = __atomic_fetch_add(&_RING->next, 1, __ATOMIC_RELAXED);
+  if (i >= _LOG_EVENTS)
+    {
+      __atomic_add_fetch(&_RING->dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+  struct LOG_EVENT* event = &_RING->events[i];
+  event->ns = ns; event->cm = _CM; event->cmd = cmd;
+  strncpy(event->rl, _RL, sizeof(event->rl)-1);
+  va_list ap;
+  va_start(ap, fs);
+  vsnprintf(event->text, sizeof(event->text), fs, ap);
+  va_end(ap);
+  __atomic_store_n(&event->committed, 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static int log_EVENT_CMP(void const * a, void const * b)
+{
+  uint64_t na = (*(struct LOG_EVENT* const *)a)->ns, nb = (*(struct LOG_EVENT* const *)b)->ns;
+  return na < nb ? -1 : na > nb;
+}
+
+void log_DUMP(void)
+/* Print the events recorded so far by this process and its children,
+   in the order they happened, when this is the parent. Called once,
+   at exit.
+*/
+{
+  static bool dumped = false;
+  if (!_RING || _RL[0] != 'P' || dumped) return;
+  dumped = true;
+
+  uint32_t rings = __atomic_load_n(&_LOG_SHM->rings_used, __ATOMIC_ACQUIRE);
+  if (rings > _LOG_RINGS) rings = _LOG_RINGS;
+  size_t count = 0; uint32_t dropped = 0;
+  for (uint32_t r=0;r<rings;r++)
+    {
+      uint32_t next = __atomic_load_n(&_LOG_SHM->rings[r].next, __ATOMIC_ACQUIRE);
+      count += next < _LOG_EVENTS ? next : _LOG_EVENTS;
+      dropped += _LOG_SHM->rings[r].dropped;
+    }
+  struct LOG_EVENT** events = malloc(sizeof(struct LOG_EVENT*)*(count+1)); assert(events);
+  size_t e = 0;
+  for (uint32_t r=0;r<rings;r++)
+    for (uint32_t i=0;i<_LOG_EVENTS && e<count;i++)
+      {
+	struct LOG_EVENT* event = &_LOG_SHM->rings[r].events[i];
+	if (!__atomic_load_n(&event->committed, __ATOMIC_ACQUIRE)) break;
+	events[e++] = event;
+      }
+  qsort(events, e, sizeof(struct LOG_EVENT*), log_EVENT_CMP);
+
+  _MX_LOCK();
+  for (size_t i=0;i<e;i++)
+    printf("[%s%c:%s] %s", events[i]->cmd ? "CMD" : "RPT",
+	   events[i]->cm, events[i]->rl, events[i]->text);
+  if (dropped) printf("[RPT%c:%s] :log-events-dropped %u\n", _CM, _RL, dropped);
+  fflush(stdout);
+  _MX_UNLOCK();
+  free(events);
+}
+#endif
+
+#ifndef _WIN32
+static char stderr_MARK(void)
+/* Return the symbol of the file type of stderr, see `log_SETUP'. */
+{
+  struct stat st;
+  int rc=fstat(fileno(stderr), &st);
+  char cm =
+    rc                  ? '?' :
+    S_ISCHR(st.st_mode)  ? '*' :
+    S_ISREG(st.st_mode)  ? '+' :
+    S_ISFIFO(st.st_mode) ? '|' :
+    S_ISSOCK(st.st_mode) ? '&' : '?';
+
+  char const * tty = cm=='*' ? ttyname(fileno(stderr)) : NULL;
+  if (tty && !strncmp(tty, "/dev/pts/", 9))
+    cm = '#';
+  return cm;
+}
+#endif
+
+static void log_CMD(int argc, char const* argv[])
+/* Print out the ARGC number of command line arguments found in ARGV
+   that started this process (or job, see `pool_WORK'). */
+{
+  bool recorded = false;
+#ifndef _WIN32
+  if (_RING)
+    {
+      char line[_LOG_TEXT]; int len = 0;
+      for(int i=1;i<argc && len<(int)sizeof(line);i++)
+	len+=snprintf(line+len, sizeof(line)-len, "%s ", argv[i]);
+      recorded = log_RECORD(true, "%s\n", line);
+    }
+#endif
+  if (!recorded)
+    {
+      _MX_LOCK();
+      printf("[CMD%c:%s] ",_CM,_RL);
+      for(int i=1;i<argc;i++){printf("%s ",argv[i]);} printf("\n");
+      fflush(stdout);
+      _MX_UNLOCK();
+    }
+}
+
+void log_SETUP(int argc, char const* argv[])
+/* Setup global logging variables and print out the ARGC number of
+   command line arguments found in ARGV that were used to start this
+   process.
+
+   When printing something out using this logging facility the file
+   type of standard error will be indicated by the following symbols:
+
+   '*' => char device or console  - `FILE_TYPE_CHAR'   or `S_ISCHR'
+   '#' => pseudo terminal         - `S_ISCHR' and a /dev/pts/ tty
+   '+' => file                    - `FILE_TYPE_DISK'   or `S_ISREG'
+   '|' => anonymous or named pipe - `FILE_TYPE_PIPE' but not a socket,
+                                    or `S_ISFIFO'
+   '&' => socket                  - `FILE_TYPE_PIPE' and is a socket,
+                                    or `S_ISSOCK'
+   '!' => remote                  - `FILE_TYPE_REMOTE'
+   '?' => unknown
+*/
+{
+  char const * deadline_ms = getenv("STEST_DEADLINE_MS");
+  if (deadline_ms && atoi(deadline_ms) > 0) _EXIT_US = atoi(deadline_ms)*1000;
+
+#ifdef _WIN32
+  _PID = GetProcessId(GetCurrentProcess());
+  {
+    HANDLE sh=(HANDLE)_get_osfhandle(_fileno(stderr)); assert(sh);
+    DWORD ft=GetFileType(sh);
+    _CM =
+      ft==FILE_TYPE_CHAR   ? '*' :
+      ft==FILE_TYPE_DISK   ? '+' :
+      ft==FILE_TYPE_PIPE   ? '|' :
+      ft==FILE_TYPE_REMOTE ? '!' : '?';
+
+    if (_CM=='|' &&
+	!GetNamedPipeInfo(sh, NULL, NULL, NULL, NULL))
+      _CM = '&';
+  }
+
+  // name of mutex is simply prefix/PID
+  char const * prefix = "pipe-test/";
+  int prefix_len = strlen(prefix);
+  
+  // check if the parent process has passed in the name of the mutex
+  // (thus this process is a child process) or create a new mutex for
+  // sync'ing logging.
+  STARTUPINFO si; memset(&si, 0, sizeof(si));
+  GetStartupInfo(&si);
+  if (si.cbReserved2>prefix_len
+      && !strncmp(prefix, (char*)si.lpReserved2+sizeof(DWORD), strlen(prefix)))
+    {
+      _RL="CHILD";      
+      _EXIT_US/=2;
+      _MX_ID = calloc(si.cbReserved2, sizeof(char));
+      strncpy(_MX_ID, (char*)si.lpReserved2+sizeof(DWORD), si.cbReserved2);
+      _OUTMX = OpenMutex(MUTEX_ALL_ACCESS, FALSE, _MX_ID); assert(_OUTMX);
+    }
+  else
+    {
+      int id_size = 1;
+      id_size+=snprintf(NULL, 0, "%s%ld", prefix, _PID);
+      _MX_ID = calloc(id_size, sizeof(char));
+      snprintf(_MX_ID, id_size, "%s%ld", prefix, _PID);
+      _OUTMX = CreateMutex(NULL, FALSE, _MX_ID); assert(_OUTMX);
+    }
+#else
+  _PID = getpid();
+  _CM = stderr_MARK();
+
+  // name of the shared memory object holding the mutex is simply
+  // prefix.PID
+  char const * prefix = "/pipe-test.";
+  int prefix_len = strlen(prefix);
+
+  // check if the parent process has passed in the name of the mutex
+  // (thus this process is a child process) or create a new mutex for
+  // sync'ing logging.
+  char const * mx_id = getenv("STEST_MX_ID");
+  // the rings, if any, share the object with the mutex, see `LOG_SHM'
+  bool ring_log = getenv("STEST_RING_LOG");
+  size_t shm_size = ring_log ? sizeof(struct LOG_SHM) : sizeof(pthread_mutex_t);
+  int shm = -1;
+  if (mx_id && !strncmp(prefix, mx_id, prefix_len))
+    {
+      _RL="CHILD";
+      _EXIT_US/=2;
+      _MX_ID = strdup(mx_id);
+      shm = shm_open(_MX_ID, O_RDWR, 0); assert(shm!=-1);
+      _OUTMX = mmap(NULL, shm_size, PROT_READ|PROT_WRITE,
+		    MAP_SHARED, shm, 0); assert(_OUTMX!=MAP_FAILED);
+    }
+  else
+    {
+      int id_size = 1;
+      id_size+=snprintf(NULL, 0, "%s%ld", prefix, (long)_PID);
+      _MX_ID = calloc(id_size, sizeof(char));
+      snprintf(_MX_ID, id_size, "%s%ld", prefix, (long)_PID);
+      shm_unlink(_MX_ID); // left behind by a crashed process with our PID
+      shm = shm_open(_MX_ID, O_RDWR|O_CREAT|O_EXCL, 0600); assert(shm!=-1);
+      atexit(mx_UNLINK);
+      int rc = ftruncate(shm, shm_size); assert(!rc);
+      _OUTMX = mmap(NULL, shm_size, PROT_READ|PROT_WRITE,
+		    MAP_SHARED, shm, 0); assert(_OUTMX!=MAP_FAILED);
+
+      pthread_mutexattr_t attr;
+      pthread_mutexattr_init(&attr);
+      pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+      pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+      rc = pthread_mutex_init(_OUTMX, &attr); assert(!rc);
+      pthread_mutexattr_destroy(&attr);
+      if (ring_log) atexit(log_DUMP);
+    }
+  close(shm);
+
+  if (ring_log && !_QUIET)
+    {
+      // a process past the last ring prints its commentary as it goes
+      _LOG_SHM = (struct LOG_SHM*)_OUTMX;
+      uint32_t ring = __atomic_fetch_add(&_LOG_SHM->rings_used, 1, __ATOMIC_ACQ_REL);
+      if (ring < _LOG_RINGS) _RING = &_LOG_SHM->rings[ring];
+    }
+#endif
+
+  
+  if (!_QUIET) log_CMD(argc, argv);
+
+  {
+#ifdef _WIN32
+    DWORD threadID;
+    HANDLE thread = CreateThread(NULL, 0, _EXIT, &_EXIT_US, 0,&threadID);
+    ASSERT(thread != NULL);
+#else
+    pthread_t thread;
+    int rc = pthread_create(&thread, NULL, _EXIT, &_EXIT_US);
+    ASSERT(rc == 0);
+#endif
+  }
+  
+}
+
+#ifdef _WIN32
+bool sweep_RUN(int const args[], int args_count)
+{
+  (void) args; (void) args_count;
+  RPT(":sweep :unsupported-on-this-platform, see report.bat\n");
+  return false;
+}
+#else
+/* an experiment of a :sweep and the state of its run */
+struct SWEEP_CELL {
+  enum e_args via, write_type, mode;
+  int write_count, read_count, pipe_size, buffer_size;
+
+  pid_t pid;         /* also the ID of its process group */
+  int out;           /* read endpoint of the pipe capturing its output */
+  char* output; int output_len, output_size;
+  uint64_t start_ns, elapsed_ns;
+  int status;
+};
+
+static int sweep_CMDLINE(struct SWEEP_CELL const * cell, int deadline_ms,
+			 char* cmdline, int size)
+/* Write the arguments of the stest instance of CELL, whose watchdog
+   gives up after DEADLINE-MS, to CMDLINE of SIZE bytes. Returns the
+   length of the complete line like snprintf(), i.e. can be called
+   with a NULL CMDLINE to size it. */
+{
+  int len = 0;
+#define _APPEND(...) len += snprintf(cmdline ? cmdline+len : NULL, \
+				     size > len ? size-len : 0, __VA_ARGS__)
+  _APPEND(":deadline-ms %d %s", deadline_ms,
+	  cell->via==eVIA_PIPE ? ":pipe-to-child-stderr"
+	  : cell->via==eVIA_SOCK ? ":sock-to-child-stderr"
+	  : cell->via==eVIA_PTY ? ":pty-to-child-stderr" : ":to-child-stderr");
+  if (cell->via==eVIA_PIPE)
+    _APPEND(" :pipe-size %d", cell->pipe_size);
+  if (cell->via!=eVIA_INHERIT)
+    _APPEND(" :read %d", cell->read_count);
+  _APPEND(" %s %d", cell->write_type==eWRITE ? ":write" : ":write-nl", cell->write_count);
+  if (cell->mode==eUNBUF)
+    _APPEND(" :unbuf");
+  else if (cell->mode)
+    _APPEND(" %s %d", cell->mode==eLNBUF ? ":lnbuf" : ":flbuf", cell->buffer_size);
+#undef _APPEND
+  return len;
+}
+
+static void sweep_START(struct SWEEP_CELL* cell, int deadline_ms, char const * exe)
+/* Start the stest instance of CELL from EXE in a new process group,
+   with its stdout and stderr redirected to a new pipe. A blocked cell
+   exits on its own after DEADLINE-MS, see :deadline-ms. */
+{
+  int cmdline_size = sweep_CMDLINE(cell, deadline_ms, NULL, 0) + 1;
+  char* cmdline = malloc(cmdline_size); ASSERT(cmdline);
+  sweep_CMDLINE(cell, deadline_ms, cmdline, cmdline_size);
+
+  char* cargv[16]; int cargc = 0;
+  cargv[cargc++] = (char*)exe;
+  for (char* tok=strtok(cmdline, " "); tok; tok=strtok(NULL, " "))
+    cargv[cargc++] = tok;
+  cargv[cargc] = NULL;
+
+  // it is a parent on its own, not a child sharing our logging mutex
+  char const * id_var = "STEST_MX_ID=";
+  int envc = 0; while (environ[envc]) envc++;
+  char* cenvp[envc+1]; int cenvc = 0;
+  for (int i=0;i<envc;i++)
+    if (strncmp(environ[i], id_var, strlen(id_var))) cenvp[cenvc++] = environ[i];
+  cenvp[cenvc] = NULL;
+
+  enum { READ, WRITE };
+  int pfds[2];
+  int rc = pipe2(pfds, O_CLOEXEC);
+  ASSERT( rc == 0 );
+
+  cell->start_ns = clock_NS();
+  cell->pid = fork();
+  ASSERT( cell->pid != -1 );
+  if (cell->pid == 0)
+    {
+      setpgid(0, 0);
+      int null = open("/dev/null", O_RDONLY);
+      dup2(null, STDIN_FILENO);
+      dup2(pfds[WRITE], STDOUT_FILENO);
+      dup2(pfds[WRITE], STDERR_FILENO);
+      execve(exe, cargv, cenvp);
+      _exit(127);
+    }
+  setpgid(cell->pid, cell->pid);
+  _close(pfds[WRITE]);
+  cell->out = pfds[READ];
+  cell->output_len = 0;
+  free(cmdline);
+}
+
+static void sweep_WRITE(struct SWEEP_CELL const * cell, int index, bool json)
+/* Write out the outcome of CELL, the INDEX'th of the sweep, as a CSV
+   row or a JSON object, as extracted from its commentary. */
+{
+  char const * out = cell->output;
+  char const * child_cmd = strstr(out, ":CHILD] ");
+  char const * child_exiting = strstr(out, ":CHILD] :exiting...");
+  char const * parent_read = strstr(out, ":PARNT] :read-bytes ");
+  int read_bytes = -1;
+  if (parent_read) sscanf(parent_read, ":PARNT] :read-bytes %d", &read_bytes);
+  // an inherited stderr is captured along with the commentary
+  char const * received = cell->via==eVIA_INHERIT ? strchr(out, '$') : parent_read;
+  if (received && read_bytes == 0) received = NULL;
+  bool before_exit = received && (!child_exiting || received < child_exiting);
+  bool parent_killed = strstr(out, ":PARNT] " _KILLED);
+  bool child_killed = strstr(out, ":CHILD] " _KILLED);
+  char child_stderr = child_cmd && child_cmd > out ? child_cmd[-1] : '?';
+  char const * mode =
+    cell->mode==eUNBUF ? "unbuf" : cell->mode==eLNBUF ? "lnbuf"
+    : cell->mode==eFLBUF ? "flbuf" : "default";
+  char const * via =
+    cell->via==eVIA_PIPE ? "pipe" : cell->via==eVIA_SOCK ? "sock"
+    : cell->via==eVIA_PTY ? "pty" : "inherit";
+  int exit_status = WIFEXITED(cell->status) ? WEXITSTATUS(cell->status) : -WTERMSIG(cell->status);
+
+  if (json)
+    printf("%s\n  {\"transport\": \"%s\", \"pipe_size\": %d, \"read_count\": %d,"
+	   " \"write\": \"%s\", \"write_count\": %d, \"mode\": \"%s\", \"buffer_size\": %d,"
+	   " \"child_stderr\": \"%c\", \"read_bytes\": %d, \"received_before_child_exit\": %s,"
+	   " \"parent_killed\": %s, \"child_killed\": %s, \"exit_status\": %d,"
+	   " \"elapsed_ms\": %.1f}",
+	   index ? "," : "[", via, cell->pipe_size, cell->read_count,
+	   cell->write_type==eWRITE ? "write" : "write-nl", cell->write_count,
+	   mode, cell->buffer_size, child_stderr, read_bytes,
+	   before_exit ? "true" : "false", parent_killed ? "true" : "false",
+	   child_killed ? "true" : "false", exit_status, cell->elapsed_ns/1e6);
+  else
+    {
+      if (!index)
+	printf("transport,pipe_size,read_count,write,write_count,mode,buffer_size,"
+	       "child_stderr,read_bytes,received_before_child_exit,"
+	       "parent_killed,child_killed,exit_status,elapsed_ms\n");
+      printf("%s,%d,%d,%s,%d,%s,%d,%c,%d,%d,%d,%d,%d,%.1f\n",
+	     via, cell->pipe_size, cell->read_count,
+	     cell->write_type==eWRITE ? "write" : "write-nl", cell->write_count,
+	     mode, cell->buffer_size, child_stderr, read_bytes,
+	     before_exit, parent_killed, child_killed, exit_status,
+	     cell->elapsed_ns/1e6);
+    }
+}
+
+bool sweep_RUN(int const args[], int args_count)
+/* Run a :sweep as described by the ARGS-COUNT entries of ARGS, which
+   follow the :sweep command.
+
+   Builds the grid of cells out of the lists of the options, runs up to
+   :jobs of them at a time and writes out the results in the order of
+   the grid once all are done. Each cell runs with a short :deadline-ms
+   (500 ms, unless given to the sweep), so that a blocked writer or
+   reader gives up soon and reports where it was stuck. A cell that has
+   still not finished within 10 seconds has its process group killed.
+*/
+{
+  enum { eLIST_VIA, eLIST_WRITE, eLIST_READ, eLIST_PSIZE, eLIST_MODE, eLIST_COUNT };
+  // each list entry is a pair, e.g. (eWRITE_NL, 10) or (eFLBUF, 512)
+  int lists[eLIST_COUNT][2*args_count+2]; int counts[eLIST_COUNT] = {0};
+  int jobs = sysconf(_SC_NPROCESSORS_ONLN); bool json = false;
+  int list = -1; enum e_args key = 0;
+  for (int i=0;i<args_count;i++)
+    {
+      int a = args[i];
+      if (a >= 0)
+	{
+	  if (key == eJOBS) { jobs = a; continue; }
+	  lists[list][2*counts[list]] = key; lists[list][2*counts[list]+1] = a;
+	  counts[list]++;
+	  continue;
+	}
+      key = a;
+      switch (a)
+	{
+	case eTRANSPORT: list = eLIST_VIA; break;
+	case eVIA_PIPE: case eVIA_SOCK: case eVIA_PTY: case eVIA_INHERIT:
+	  lists[eLIST_VIA][2*counts[eLIST_VIA]] = a; counts[eLIST_VIA]++; break;
+	case eWRITE: case eWRITE_NL: list = eLIST_WRITE; break;
+	case eREAD: list = eLIST_READ; break;
+	case ePIPE_SIZE: list = eLIST_PSIZE; break;
+	case eLNBUF: case eFLBUF: list = eLIST_MODE; break;
+	case eDEFAULT: case eUNBUF:
+	  lists[eLIST_MODE][2*counts[eLIST_MODE]] = a == eDEFAULT ? 0 : a;
+	  lists[eLIST_MODE][2*counts[eLIST_MODE]+1] = 0;
+	  counts[eLIST_MODE]++; break;
+	case eJSON: json = true; break;
+	default: break;
+	}
+    }
+  int const defaults[][2] = { [eLIST_READ]={eREAD, 1}, [eLIST_PSIZE]={ePIPE_SIZE, 0},
+			      [eLIST_MODE]={0, 0} };
+  for (int l=eLIST_READ;l<eLIST_COUNT;l++)
+    if (!counts[l]) { lists[l][0] = defaults[l][0]; lists[l][1] = defaults[l][1]; counts[l] = 1; }
+
+  // the pipe size and read count only apply to some of the transports
+  int cells_size = counts[eLIST_VIA]*counts[eLIST_WRITE]*counts[eLIST_READ]
+    *counts[eLIST_PSIZE]*counts[eLIST_MODE];
+  struct SWEEP_CELL* cells = calloc(cells_size, sizeof(struct SWEEP_CELL)); ASSERT(cells);
+  int cells_count = 0;
+  for (int v=0;v<counts[eLIST_VIA];v++)
+    {
+      enum e_args via = lists[eLIST_VIA][2*v];
+      for (int p=0;p<(via==eVIA_PIPE ? counts[eLIST_PSIZE] : 1);p++)
+	for (int r=0;r<(via!=eVIA_INHERIT ? counts[eLIST_READ] : 1);r++)
+	  for (int w=0;w<counts[eLIST_WRITE];w++)
+	    for (int m=0;m<counts[eLIST_MODE];m++)
+	      {
+		struct SWEEP_CELL* cell = &cells[cells_count++];
+		cell->via = via;
+		cell->pipe_size = via==eVIA_PIPE ? lists[eLIST_PSIZE][2*p+1] : 0;
+		cell->read_count = via!=eVIA_INHERIT ? lists[eLIST_READ][2*r+1] : 0;
+		cell->write_type = lists[eLIST_WRITE][2*w];
+		cell->write_count = lists[eLIST_WRITE][2*w+1];
+		cell->mode = lists[eLIST_MODE][2*m];
+		cell->buffer_size = lists[eLIST_MODE][2*m+1];
+		cell->out = -1;
+	      }
+    }
+
+  char exe[PATH_MAX];
+  ssize_t exe_len = readlink("/proc/self/exe", exe, sizeof(exe)-1);
+  ASSERT( exe_len > 0 );
+  exe[exe_len] = 0;
+
+  int const cell_deadline_ms = getenv("STEST_DEADLINE_MS") ? _EXIT_US/1000 : 500;
+  uint64_t const deadline_ns = 10000000000ULL;
+  int next = 0, running = 0, done = 0;
+  struct pollfd fds[jobs]; int fds_cell[jobs];
+  while (done < cells_count)
+    {
+      while (running < jobs && next < cells_count)
+	{
+	  sweep_START(&cells[next++], cell_deadline_ms, exe);
+	  running++;
+	}
+
+      int nfds = 0;
+      for (int c=0;c<next;c++)
+	if (cells[c].out != -1)
+	  {
+	    fds[nfds].fd = cells[c].out; fds[nfds].events = POLLIN;
+	    fds_cell[nfds++] = c;
+	  }
+      int rc = poll(fds, nfds, 100);
+      ASSERT( rc != -1 || errno == EINTR );
+      _KICK();
+
+      uint64_t now = clock_NS();
+      for (int f=0;f<nfds;f++)
+	{
+	  struct SWEEP_CELL* cell = &cells[fds_cell[f]];
+	  if (fds[f].revents)
+	    {
+	      if (cell->output_size - cell->output_len < 4096)
+		{
+		  cell->output_size = 2*cell->output_size + 4096;
+		  cell->output = realloc(cell->output, cell->output_size); ASSERT(cell->output);
+		}
+	      int read = _read(cell->out, cell->output+cell->output_len,
+			       cell->output_size-cell->output_len-1);
+	      if (read > 0) { cell->output_len += read; continue; }
+	    }
+	  else if (now - cell->start_ns < deadline_ns)
+	    continue;
+
+	  // finished, or got stuck: take the whole process group down
+	  killpg(cell->pid, SIGKILL);
+	  while (waitpid(cell->pid, &cell->status, 0) == -1 && errno == EINTR) continue;
+	  cell->elapsed_ns = clock_NS() - cell->start_ns;
+	  cell->output[cell->output_len] = 0;
+	  _close(cell->out);
+	  cell->out = -1;
+	  running--; done++;
+	}
+    }
+
+  for (int c=0;c<cells_count;c++)
+    {
+      sweep_WRITE(&cells[c], c, json);
+      free(cells[c].output);
+    }
+  if (json) printf("%s]\n", cells_count ? "\n" : "[");
+  fflush(stdout);
+  free(cells);
+  return true;
+}
+#endif
+
+#ifdef _WIN32
+void fanin_BENCH(enum e_args via, int children, int repeat, int write_count)
+{
+  (void) via; (void) children; (void) repeat; (void) write_count;
+  RPT(":fanin-children :unsupported-on-this-platform\n");
+}
+#else
+/* a child of a :fanin-children experiment, and the record of it that
+   is being received */
+struct FANIN_CHILD {
+  child_t child;
+  int fd;             /* read endpoint of its stderr */
+  char* record; int got;
+  uint64_t arrived;   /* when the first byte of the record arrived */
+  uint64_t delay_ns; int records;
+};
+
+static bool fanin_DRAIN(int epfd, struct FANIN_CHILD* fcs, int record_len,
+			struct HISTOGRAM* hist, long long* bytes, int timeout_ms)
+/* Wait up to TIMEOUT-MS for any of the FCS children registered with
+   EPFD to become readable and read from them. The delay of every
+   complete RECORD-LEN record is added to HIST and the bytes read to
+   BYTES. A child is reaped on EOF.
+
+   Return true if any child was ready.
+*/
+{
+  struct epoll_event events[64];
+  int ready = epoll_wait(epfd, events, 64, timeout_ms);
+  ASSERT( ready != -1 || errno == EINTR );
+  char chunk[1<<16];
+  for (int e=0;e<ready;e++)
+    {
+      struct FANIN_CHILD* fc = &fcs[events[e].data.u32];
+      int read = _read(fc->fd, chunk, sizeof(chunk));
+      uint64_t now = clock_NS();
+      if (read <= 0)
+	{
+	  epoll_ctl(epfd, EPOLL_CTL_DEL, fc->fd, NULL);
+	  _close(fc->fd); fc->fd = -1;
+	  child_WAIT(fc->child);
+	  continue;
+	}
+      *bytes += read;
+      for (int i=0;i<read;)
+	{
+	  if (!fc->got) fc->arrived = now;
+	  int take = record_len - fc->got < read - i ? record_len - fc->got : read - i;
+	  memcpy(fc->record + fc->got, chunk + i, take);
+	  fc->got += take; i += take;
+	  if (fc->got < record_len) break;
+
+	  unsigned long long stamped = 0;
+	  int scanned = sscanf(fc->record, "@%llu", &stamped);
+	  ASSERT(scanned == 1 && stamped <= fc->arrived);
+	  hist_ADD(hist, fc->arrived - stamped);
+	  fc->delay_ns += fc->arrived - stamped; fc->records++;
+	  fc->got = 0;
+	}
+    }
+  _KICK();
+  return ready > 0;
+}
+
+void fanin_BENCH(enum e_args via, int children, int repeat, int write_count)
+/* Spawn CHILDREN child processes, each with its stderr redirected to
+   its own _pipe() (VIA is `eVIA_PIPE') or socket (`eVIA_SOCK'), that
+   write REPEAT timestamped records of WRITE-COUNT '$' chars (see
+   `stamp_SET').
+
+   The parent drains all of them through a single epoll instance, even
+   while still spawning, so that no child sits blocked on a full
+   stderr.
+
+   Reports the aggregate throughput, the distribution of the delays
+   until the first byte of each record arrived, and the lowest and
+   highest mean delay of any child.
+*/
+{
+  // one descriptor per child, plus the few of our own
+  struct rlimit rl;
+  getrlimit(RLIMIT_NOFILE, &rl);
+  if (rl.rlim_cur < (rlim_t)children + 64 && rl.rlim_cur < rl.rlim_max)
+    {
+      rl.rlim_cur = rl.rlim_max;
+      setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+  char cmdargs[64];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs),
+			      ":to-stderr :quiet :stamp :repeat %d :write %d",
+			      repeat, write_count);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+  int const record_len = _STAMP_LEN + write_count;
+
+  struct FANIN_CHILD* fcs = calloc(children, sizeof(struct FANIN_CHILD)); ASSERT(fcs);
+  struct HISTOGRAM* hist = calloc(1, sizeof(struct HISTOGRAM)); ASSERT(hist);
+  int epfd = epoll_create1(EPOLL_CLOEXEC);
+  ASSERT( epfd != -1 );
+
+  enum { READ, WRITE };
+  long long bytes = 0;
+  uint64_t cpu_start = cpu_NS(), start = clock_NS();
+  for (int c=0;c<children;c++)
+    {
+      struct FANIN_CHILD* fc = &fcs[c];
+      fc->record = malloc(record_len); ASSERT(fc->record);
+      if (via == eVIA_SOCK)
+	{
+	  SOCKET sfds[2];
+	  socket_PAIR(sfds);
+	  fc->child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(fc->child);
+	  closesocket(sfds[WRITE]);
+	  fc->fd = sfds[READ];
+	}
+      else
+	{
+	  int pfds[2];
+	  int rc = pipe_OPEN (pfds, 0);
+	  ASSERT( rc == 0 );
+	  fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+	  fc->child = child_SPAWN(cmdargs, write_handle); ASSERT(fc->child);
+	  handle_CLOSE(write_handle);
+	  fc->fd = pfds[READ];
+	}
+      struct epoll_event event = { .events = EPOLLIN, .data.u32 = c };
+      int rc = epoll_ctl(epfd, EPOLL_CTL_ADD, fc->fd, &event);
+      ASSERT( rc == 0 );
+      while (fanin_DRAIN(epfd, fcs, record_len, hist, &bytes, 0)) continue;
+    }
+  uint64_t spawned = clock_NS()-start;
+
+  for (int open=children;open;)
+    {
+      fanin_DRAIN(epfd, fcs, record_len, hist, &bytes, 100);
+      open = 0;
+      for (int c=0;c<children;c++) open += fcs[c].fd != -1;
+    }
+  uint64_t elapsed = clock_NS()-start, cpu = cpu_NS()-cpu_start;
+  _close(epfd);
+
+  uint64_t mean_min = UINT64_MAX, mean_max = 0;
+  for (int c=0;c<children;c++)
+    {
+      ASSERT(fcs[c].records == repeat);
+      uint64_t mean = fcs[c].delay_ns / fcs[c].records;
+      if (mean < mean_min) mean_min = mean;
+      if (mean > mean_max) mean_max = mean;
+      free(fcs[c].record);
+    }
+
+  RPT(":fanin :transport %s :children %d :mbytes %.1f :mb-per-s %.1f"
+      " :spawn-ms %.1f :parent-cpu-ms %.1f\n",
+      via==eVIA_SOCK ? "sock" : "pipe", children, bytes/1048576.0,
+      bytes/1048576.0/(elapsed/1e9), spawned/1e6, cpu/1e6);
+  RPT(":fanin-latency-us :children %d :count %llu :p50 %.3f :p90 %.3f :p99 %.3f :max %.3f"
+      " :child-mean-min %.3f :child-mean-max %.3f\n",
+      children, (unsigned long long)hist->total,
+      hist_PERCENTILE(hist, 50)/1e3, hist_PERCENTILE(hist, 90)/1e3,
+      hist_PERCENTILE(hist, 99)/1e3, hist->max/1e3, mean_min/1e3, mean_max/1e3);
+  free(hist);
+  free(fcs);
+}
+#endif
+
+#ifdef _WIN32
+void preload_BENCH(enum e_args policy, int policy_value, int runs, int mbytes,
+		   enum e_args write_type, int write_count, enum e_args mode, int buffer_size)
+{
+  (void) policy; (void) policy_value; (void) runs; (void) mbytes;
+  (void) write_type; (void) write_count; (void) mode; (void) buffer_size;
+  RPT(":preload :unsupported-on-this-platform\n");
+}
+#else
+void preload_BENCH(enum e_args policy, int policy_value, int runs, int mbytes,
+		   enum e_args write_type, int write_count, enum e_args mode, int buffer_size)
+/* Measure the delay of RUNS timestamped records (see
+   `latency_to_child_stderr') and the throughput of MBYTES (see
+   `throughput_BENCH') of a child writing WRITE-COUNT '$' chars with
+   WRITE-TYPE to its stderr, a _pipe(), in buffering MODE with a buffer
+   of BUFFER-SIZE. The measurements are made first as is, and then
+   with the stest-preload.so shim, which sits next to the executable,
+   preloaded into the child to override the child's buffering with
+   POLICY (see stderr-preload.c) and its POLICY-VALUE.
+*/
+{
+  char shim[PATH_MAX];
+  ssize_t shim_len = readlink("/proc/self/exe", shim, sizeof(shim)-1);
+  ASSERT( shim_len > 0 );
+  shim[shim_len] = 0;
+  char* dir = strrchr(shim, '/');
+  ASSERT( dir && dir-shim+sizeof("/stest-preload.so") <= sizeof(shim) );
+  strcpy(dir, "/stest-preload.so");
+  if (access(shim, R_OK))
+    {
+      RPT(":preload :shim %s :not-found, run make\n", shim);
+      return;
+    }
+
+  char policy_env[32];
+  switch (policy)
+    {
+    case ePOLICY_UNBUF: snprintf(policy_env, sizeof(policy_env), "unbuf"); break;
+    case ePOLICY_LNBUF: snprintf(policy_env, sizeof(policy_env), "lnbuf"); break;
+    case ePOLICY_BYTES: snprintf(policy_env, sizeof(policy_env), "bytes:%d", policy_value); break;
+    case ePOLICY_US: snprintf(policy_env, sizeof(policy_env), "us:%d", policy_value); break;
+    default: ASSERT(false);
+    }
+
+  char mode_args[32] = "";
+  if (mode == eUNBUF)
+    snprintf(mode_args, sizeof(mode_args), " :unbuf");
+  else if (mode)
+    snprintf(mode_args, sizeof(mode_args), " %s %d",
+	     mode==eLNBUF ? ":lnbuf" : ":flbuf", buffer_size);
+  char cmdargs[96];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs), ":to-stderr :quiet :stamp %s %d%s",
+			      write_type==eWRITE_NL ? ":write-nl" : ":write",
+			      write_count, mode_args);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+  int record_len = _STAMP_LEN + write_count + (write_type==eWRITE_NL);
+
+  for (int on=0;on<2;on++)
+    {
+      if (on)
+	{
+	  ASSERT( !setenv("LD_PRELOAD", shim, 1) );
+	  ASSERT( !setenv("STEST_PRELOAD_POLICY", policy_env, 1) );
+	}
+      RPT(":preload :policy %s :%s\n", policy_env, on ? "on" : "off");
+      latency_to_child_stderr(eVIA_PIPE, 0, runs, record_len, cmdargs, eREAD_BLOCKING);
+      throughput_BENCH(eVIA_PIPE, mbytes, write_count, 0, mode, 0, buffer_size,
+		       eREAD_BLOCKING, 0, 0, 0, 0);
+    }
+  unsetenv("LD_PRELOAD");
+  unsetenv("STEST_PRELOAD_POLICY");
+}
+#endif
+
+char const * stream_NAME(enum e_args kind)
+/* Return the name of the :stream KIND as given on the command line,
+   fwrite when not set. */
+{
+  return kind==eSTREAM_CERR ? "cerr" : kind==eSTREAM_CLOG ? "clog"
+    : kind==eSTREAM_WRITE2 ? "write2" : kind==eAPI_FPUTC ? "fputc"
+    : kind==eAPI_FPUTS ? "fputs" : kind==eAPI_FPRINTF ? "fprintf"
+    : kind==eAPI_FWRITE_UNLOCKED ? "fwrite-unlocked" : kind==eAPI_WRITEV ? "writev"
+    : "fwrite";
+}
+
+bool stream_MODE_OK(enum e_args kind, enum e_args mode)
+/* Return whether the buffering MODE, none when 0, applies to the
+   :stream KIND or :write-api API. write2 and writev have no buffer,
+   and iostreams are either in sync with stdio or have a buffer of their
+   own, which is never line buffered or adaptive. */
+{
+  switch (kind)
+    {
+    case eSTREAM_WRITE2: case eAPI_WRITEV: return !mode;
+    case eSTREAM_CERR: case eSTREAM_CLOG: return !mode || mode == eUNBUF || mode == eFLBUF;
+    default: return true;
+    }
+}
+
+bool api_OK(enum e_args api, int call_bytes)
+/* Return whether API is one of :write-api's, available on this
+   platform, writing CALL-BYTES chars a call. fputc() puts just one. */
+{
+  switch (api)
+    {
+    case eAPI_FPUTC: return call_bytes == 1;
+#ifdef _WIN32
+    case eAPI_WRITEV: return false;
+#endif
+    case eSTREAM_FWRITE: case eSTREAM_WRITE2: case eAPI_FPUTS: case eAPI_FPRINTF:
+    case eAPI_FWRITE_UNLOCKED: case eAPI_WRITEV:
+      return call_bytes > 0;
+    default: return false;
+    }
+}
+
+/* the pieces gathered in a single writev() by :write-api writev */
+#define _WRITEV_BATCH 64
+
+long long api_WRITE(enum e_args api, FILE* stream, int fd, char* msg, int msg_len,
+		    int call_bytes)
+/* Write the MSG of MSG-LEN chars with :write-api API, a call for each
+   CALL-BYTES of it, to STREAM, or straight to its handle FD for write2
+   and writev, which gathers up to _WRITEV_BATCH such pieces in a
+   syscall. MSG must have room for a '\0' past its end, for fputs().
+
+   Return the chars written.
+*/
+{
+  long long put = 0;
+  switch (api)
+    {
+    case eAPI_FPUTC:
+      for (int i=0;i<msg_len;i++)
+	if (fputc(msg[i], stream) != EOF) ++put;
+      break;
+    case eAPI_FPUTS:
+      for (int i=0;i<msg_len;i+=call_bytes)
+	{
+	  int len = msg_len-i < call_bytes ? msg_len-i : call_bytes;
+	  char held = msg[i+len];
+	  msg[i+len] = '\0';
+	  if (fputs(msg+i, stream) != EOF) put += len;
+	  msg[i+len] = held;
+	}
+      break;
+    case eAPI_FPRINTF:
+      for (int i=0;i<msg_len;i+=call_bytes)
+	{
+	  int len = msg_len-i < call_bytes ? msg_len-i : call_bytes;
+	  int printed = fprintf(stream, "%.*s", len, msg+i);
+	  if (printed > 0) put += printed;
+	}
+      break;
+    case eAPI_FWRITE_UNLOCKED:
+      // the lock taken once, as the callers of the _unlocked calls must
+      flockfile(stream);
+      for (int i=0;i<msg_len;i+=call_bytes)
+	put += fwrite_unlocked(msg+i, sizeof(char),
+			       msg_len-i < call_bytes ? msg_len-i : call_bytes, stream);
+      funlockfile(stream);
+      break;
+    case eSTREAM_WRITE2:
+      for (int i=0;i<msg_len;i+=call_bytes)
+	{
+	  int len = msg_len-i < call_bytes ? msg_len-i : call_bytes;
+	  for (int done=0;done<len;)
+	    {
+	      int moved = _write(fd, msg+i+done, len-done);
+	      if (moved <= 0) return put;
+	      done += moved; put += moved;
+	    }
+	}
+      break;
+#ifndef _WIN32
+    case eAPI_WRITEV:
+      for (int i=0;i<msg_len;)
+	{
+	  struct iovec iov[_WRITEV_BATCH];
+	  int iovcnt = 0;
+	  for (;iovcnt<_WRITEV_BATCH && i<msg_len;iovcnt++,i+=call_bytes)
+	    {
+	      iov[iovcnt].iov_base = msg+i;
+	      iov[iovcnt].iov_len = msg_len-i < call_bytes ? msg_len-i : call_bytes;
+	    }
+	  // a short write leaves the rest of the batch for the next one
+	  for (struct iovec* next=iov;iovcnt;)
+	    {
+	      ssize_t moved = writev(fd, next, iovcnt);
+	      if (moved <= 0) return put;
+	      put += moved;
+	      while (iovcnt && (size_t)moved >= next->iov_len)
+		{
+		  moved -= next->iov_len; ++next; --iovcnt;
+		}
+	      if (iovcnt)
+		{
+		  next->iov_base = (char*)next->iov_base + moved;
+		  next->iov_len -= moved;
+		}
+	    }
+	}
+      break;
+#endif
+    default:
+      for (int i=0;i<msg_len;i+=call_bytes)
+	put += fwrite(msg+i, sizeof(char),
+		      msg_len-i < call_bytes ? msg_len-i : call_bytes, stream);
+    }
+  return put;
+}
+
+int64_t api_SYSCALLS(void)
+/* Return the write syscalls this process issued so far, or -1 when
+   unknown, for :write-api to report. */
+{
+#ifdef _WIN32
+  return -1;
+#else
+  return io_SYSCW(getpid());
+#endif
+}
+
+#ifdef _WIN32
+long long threads_WRITE(FILE* stream, int fd, int threads, int thread_buffer,
+			char const * msg, int msg_len, int repeat, char const * mode_name)
+{
+  (void) stream; (void) fd; (void) threads; (void) thread_buffer; (void) msg;
+  (void) msg_len; (void) repeat; (void) mode_name;
+  RPT(":writer-threads :unsupported-on-this-platform\n");
+  return 0;
+}
+#else
+/* one of the :writer-threads of `threads_WRITE' */
+struct WRITER {
+  pthread_t thread;
+  FILE* stream; int fd;
+  char* msg; int msg_len, repeat;
+  int thread_buffer;       /* the size of its own buffer, none when 0 */
+  long long wrote, puts;
+  long long contended;     /* puts that found the stream locked */
+  uint64_t lock_wait_ns;   /* the time those waited for it */
+};
+
+static void writer_PUT(struct WRITER* writer, char const * data, int len, bool unlocked)
+/* Write LEN chars of DATA to the WRITER's stream, taking the time the
+   stream's lock was held by another thread, if it was. With UNLOCKED
+   the chars go out with a single fwrite_unlocked() under the lock. */
+{
+  uint64_t before = clock_NS();
+  if (ftrylockfile(writer->stream))
+    {
+      flockfile(writer->stream);
+      writer->contended++;
+      writer->lock_wait_ns += clock_NS()-before;
+    }
+  writer->wrote += unlocked
+    ? fwrite_unlocked(data, sizeof(char), len, writer->stream)
+    : fwrite(data, sizeof(char), len, writer->stream);
+  funlockfile(writer->stream);
+  writer->puts++;
+}
+
+static void* writer_RUN(void* _writer)
+/* Write the record of the _WRITER REPEAT times, with fwrite() to its
+   stream, with _write() to its FD when set, or collected in a buffer
+   of its own that goes out with `writer_PUT' when full. */
+{
+  struct WRITER* writer = _writer;
+  char* buffer = writer->thread_buffer ? malloc(writer->thread_buffer) : NULL;
+  int used = 0;
+  for (int i=0;i<writer->repeat;i++)
+    {
+      if (writer->fd >= 0)
+	{
+	  for (int done=0;done<writer->msg_len;)
+	    {
+	      int moved = _write(writer->fd, writer->msg+done, writer->msg_len-done);
+	      if (moved <= 0) return NULL;
+	      done += moved; writer->wrote += moved;
+	    }
+	  writer->puts++;
+	  continue;
+	}
+      if (!buffer)
+	{
+	  writer_PUT(writer, writer->msg, writer->msg_len, false);
+	  continue;
+	}
+      if (used + writer->msg_len > writer->thread_buffer)
+	{
+	  if (used) writer_PUT(writer, buffer, used, true);
+	  used = 0;
+	}
+      // too large for the buffer, goes out on its own
+      if (writer->msg_len > writer->thread_buffer)
+	writer_PUT(writer, writer->msg, writer->msg_len, true);
+      else
+	{
+	  memcpy(buffer+used, writer->msg, writer->msg_len);
+	  used += writer->msg_len;
+	}
+    }
+  if (used) writer_PUT(writer, buffer, used, true);
+  free(buffer);
+  return NULL;
+}
+
+long long threads_WRITE(FILE* stream, int fd, int threads, int thread_buffer,
+			char const * msg, int msg_len, int repeat, char const * mode_name)
+/* Start THREADS threads that each write the MSG of MSG-LEN chars
+   REPEAT times to STREAM at the same time, with the '$'s of it
+   replaced by a char of `_WRITER_MARKS' of their own, for a reader to
+   tell them apart. With FD set they _write() to it instead, and with
+   THREAD-BUFFER each collects its records in a buffer of that size
+   first (see `writer_RUN').
+
+   Reports the throughput, the puts that found the stream locked by
+   another thread and the time they waited for it, also as a share of
+   the time the threads took altogether, under the stream's buffering
+   MODE-NAME.
+
+   Return the chars written.
+*/
+{
+  struct WRITER* writers = calloc(threads, sizeof(struct WRITER)); ASSERT(writers);
+  uint64_t start = clock_NS();
+  for (int t=0;t<threads;t++)
+    {
+      struct WRITER* writer = &writers[t];
+      writer->stream = stream; writer->fd = fd;
+      writer->msg = malloc(msg_len); ASSERT(writer->msg);
+      for (int i=0;i<msg_len;i++)
+	writer->msg[i] = msg[i] == '$' ? _WRITER_MARKS[t] : msg[i];
+      writer->msg_len = msg_len; writer->repeat = repeat;
+      writer->thread_buffer = thread_buffer;
+      int rc = pthread_create(&writer->thread, NULL, writer_RUN, writer);
+      ASSERT(rc == 0);
+    }
+  long long wrote = 0, puts = 0, contended = 0;
+  uint64_t lock_wait_ns = 0;
+  for (int t=0;t<threads;t++)
+    {
+      struct WRITER* writer = &writers[t];
+      pthread_join(writer->thread, NULL);
+      wrote += writer->wrote; puts += writer->puts; contended += writer->contended;
+      lock_wait_ns += writer->lock_wait_ns;
+      free(writer->msg);
+      _KICK();
+    }
+  if (fd < 0) fflush(stream);
+  uint64_t elapsed = clock_NS()-start;
+  free(writers);
+
+  double mb_per_s = wrote/1048576.0/(elapsed/1e9);
+  RPT(":writer-threads %d :variant %s :thread-buffer %d :mode %s :mbytes %.1f :mb-per-s %.1f"
+      " :mb-per-s-per-thread %.1f :puts %lld :lock-contended %lld :lock-wait-ms %.1f"
+      " :lock-wait-share %.1f%%\n",
+      threads, fd >= 0 ? "write2" : thread_buffer ? "fwrite-unlocked" : "fwrite",
+      thread_buffer, mode_name, wrote/1048576.0, mb_per_s, mb_per_s/threads, puts,
+      contended, lock_wait_ns/1e6, 100.0*lock_wait_ns/((double)elapsed*threads));
+  return wrote;
+}
+#endif
+
+#ifdef _WIN32
+FILE* adaptive_OPEN(int max_delay_us, int buffer_size)
+{
+  (void) max_delay_us; (void) buffer_size;
+  RPT(":adaptive :unsupported-on-this-platform\n");
+  return NULL;
+}
+#else
+/* the state of an :adaptive stderr stream, see `adaptive_OPEN' */
+struct ADAPTIVE {
+  char* buffer; size_t size, used;
+  uint64_t oldest_ns;     /* when the oldest buffered byte was written */
+  uint64_t max_delay_ns;
+  uint64_t worst_ns;      /* longest any byte was held back */
+  long flushes;           /* write syscalls issued */
+  bool closing;
+  pthread_mutex_t mx; pthread_cond_t cv;
+  pthread_t flusher;
+};
+
+static void adaptive_FLUSH(struct ADAPTIVE* ad)
+/* Write out what AD holds to stderr, with AD's mutex held. */
+{
+  if (!ad->used) return;
+  uint64_t held = clock_NS() - ad->oldest_ns;
+  if (held > ad->worst_ns) ad->worst_ns = held;
+  for (size_t done=0;done<ad->used;)
+    {
+      uint64_t before = _TIMELINE ? clock_NS() : 0;
+      ssize_t wrote = write(STDERR_FILENO, ad->buffer+done, ad->used-done);
+      ad->flushes++;
+      if (_TIMELINE && wrote > 0)
+	timeline_ADD(eEV_FLUSH, before, clock_NS()-before, STDERR_FILENO, wrote, 0);
+      if (wrote < 0 && errno == EINTR) continue;
+      if (wrote <= 0) break;
+      done += wrote;
+    }
+  ad->used = 0;
+}
+
+static ssize_t adaptive_WRITE(void* cookie, char const * buf, size_t size)
+{
+  struct ADAPTIVE* ad = cookie;
+  pthread_mutex_lock(&ad->mx);
+  if (ad->used + size > ad->size) adaptive_FLUSH(ad);
+  if (size >= ad->size)
+    {
+      // too large to coalesce, goes out as is
+      ad->oldest_ns = clock_NS();
+      char* const held = ad->buffer;
+      ad->buffer = (char*)buf; ad->used = size;
+      adaptive_FLUSH(ad);
+      ad->buffer = held;
+    }
+  else
+    {
+      if (!ad->used)
+	{
+	  ad->oldest_ns = clock_NS();
+	  pthread_cond_signal(&ad->cv);
+	}
+      memcpy(ad->buffer + ad->used, buf, size);
+      ad->used += size;
+    }
+  pthread_mutex_unlock(&ad->mx);
+  return size;
+}
+
+static void* adaptive_FLUSHER(void* cookie)
+/* Flush the stream once its oldest byte has been held back for the
+   maximum delay. */
+{
+  struct ADAPTIVE* ad = cookie;
+  pthread_mutex_lock(&ad->mx);
+  while (!ad->closing)
+    {
+      if (!ad->used)
+	{
+	  pthread_cond_wait(&ad->cv, &ad->mx);
+	  continue;
+	}
+      uint64_t deadline = ad->oldest_ns + ad->max_delay_ns;
+      if (clock_NS() >= deadline)
+	{
+	  adaptive_FLUSH(ad);
+	  continue;
+	}
+      struct timespec ts = { deadline/1000000000, deadline%1000000000 };
+      pthread_cond_timedwait(&ad->cv, &ad->mx, &ts);
+    }
+  pthread_mutex_unlock(&ad->mx);
+  return NULL;
+}
+
+static int adaptive_CLOSE(void* cookie)
+{
+  struct ADAPTIVE* ad = cookie;
+  pthread_mutex_lock(&ad->mx);
+  ad->closing = true;
+  pthread_cond_signal(&ad->cv);
+  pthread_mutex_unlock(&ad->mx);
+  pthread_join(ad->flusher, NULL);
+  adaptive_FLUSH(ad);
+  if (!_QUIET) RPT(":adaptive :max-delay-us %.0f :buffer-size %zu :write-syscalls %ld"
+		   " :worst-delay-us %.3f\n", ad->max_delay_ns/1e3, ad->size,
+		   ad->flushes, ad->worst_ns/1e3);
+  pthread_cond_destroy(&ad->cv);
+  pthread_mutex_destroy(&ad->mx);
+  free(ad->buffer);
+  free(ad);
+  return 0;
+}
+
+FILE* adaptive_OPEN(int max_delay_us, int buffer_size)
+/* Return a new stream writing to stderr's handle, that coalesces the
+   writes in a buffer of BUFFER-SIZE, but never holds a byte back for
+   longer than MAX-DELAY-US: a flusher thread writes the buffer out
+   when its oldest byte is due. It reports the write syscalls issued
+   and the longest delay when closed.
+
+   Return NULL on error.
+*/
+{
+  struct ADAPTIVE* ad = calloc(1, sizeof(*ad));
+  ASSERT(ad);
+  ad->buffer = malloc(buffer_size); ASSERT(ad->buffer);
+  ad->size = buffer_size;
+  ad->max_delay_ns = (uint64_t)max_delay_us*1000;
+  pthread_mutex_init(&ad->mx, NULL);
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  // the deadlines are taken from `clock_NS'
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&ad->cv, &attr);
+  pthread_condattr_destroy(&attr);
+  ASSERT( !pthread_create(&ad->flusher, NULL, adaptive_FLUSHER, ad) );
+
+  cookie_io_functions_t io = { .write = adaptive_WRITE, .close = adaptive_CLOSE };
+  FILE* stream = fopencookie(ad, "w", io);
+  if (!stream) { adaptive_CLOSE(ad); return NULL; }
+  // every fwrite() reaches the cookie, which does the buffering
+  setvbuf(stream, NULL, _IONBF, 0);
+  return stream;
+}
+#endif
+
+void timeline_ADD(enum e_events kind, uint64_t ns, uint64_t dur, int fd, long long bytes,
+		  char aux)
+/* Append an event of KIND of this process, that started at NS and took
+   DUR ns, to the :trace timeline if there is one (see `TIMELINE_EVENT'
+   for FD, BYTES and AUX). The events past its capacity are dropped. */
+{
+  if (!_TIMELINE) return;
+  uint64_t i = __atomic_fetch_add(&_TIMELINE->claimed, 1, __ATOMIC_RELAXED);
+  if (i >= _TIMELINE->capacity) return;
+  struct TIMELINE_EVENT* ev = &_TIMELINE->events[i];
+  ev->ns = ns; ev->dur = dur; ev->bytes = bytes;
+  ev->pid = _PID; ev->fd = fd; ev->aux = aux;
+  __atomic_store_n(&ev->kind, kind, __ATOMIC_RELEASE);
+}
+
+#ifdef _WIN32
+void timeline_OPEN(char const * path, bool create)
+{
+  (void) path; (void) create;
+  RPT(":trace :unsupported-on-this-platform\n");
+}
+
+FILE* timeline_STREAM(FILE* like)
+{
+  return like;
+}
+#else
+static void timeline_EXIT(void)
+{
+  // what the streams still hold goes out now rather than after the
+  // atexit() handlers, for the exit to be the last event
+  fflush(NULL);
+  timeline_ADD(eEV_EXIT, clock_NS(), 0, -1, 0, 0);
+}
+
+void timeline_OPEN(char const * path, bool create)
+/* Map the :trace timeline file at PATH, created anew when CREATE is set
+   (the parent), and record the start and the exit of this process in
+   it. */
+{
+  size_t size = sizeof(struct TIMELINE)
+    + (size_t)_TIMELINE_EVENTS*sizeof(struct TIMELINE_EVENT);
+  int fd = open(path, O_RDWR|O_CLOEXEC|(create ? O_CREAT|O_TRUNC : 0), 0644);
+  if (fd == -1 || (create && ftruncate(fd, size) == -1))
+    {
+      RPT(":trace %s :unavailable :errno %d\n", path, errno);
+      if (fd != -1) close(fd);
+      return;
+    }
+  struct TIMELINE* tl = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  ASSERT( tl != MAP_FAILED );
+  if (create)
+    {
+      memcpy(tl->magic, _TIMELINE_MAGIC, sizeof(tl->magic));
+      tl->capacity = _TIMELINE_EVENTS;
+    }
+  ASSERT( !memcmp(tl->magic, _TIMELINE_MAGIC, sizeof(tl->magic)) );
+  _TIMELINE = tl;
+  timeline_ADD(eEV_START, clock_NS(), 0, -1, 0, strcmp(_RL, "CHILD") ? 'P' : 'C');
+  atexit(timeline_EXIT);
+}
+
+static ssize_t timeline_WRITE(void* cookie, char const * buf, size_t size)
+{
+  int fd = (int)(intptr_t)cookie;
+  size_t done = 0;
+  while (done < size)
+    {
+      uint64_t before = clock_NS();
+      ssize_t wrote = write(fd, buf+done, size-done);
+      if (wrote < 0 && errno == EINTR) continue;
+      if (wrote <= 0) return done ? (ssize_t)done : -1;
+      timeline_ADD(eEV_FLUSH, before, clock_NS()-before, fd, wrote, 0);
+      done += wrote;
+    }
+  return done;
+}
+
+FILE* timeline_STREAM(FILE* like)
+/* Return a new stream in place of LIKE, stderr or stdout, writing to
+   its handle with the buffering glibc gives LIKE by default, whose
+   write syscalls are recorded in the :trace timeline; those stdio
+   issues on LIKE's behalf can not be seen otherwise. */
+{
+  int fd = fileno(like);
+  cookie_io_functions_t io = { .write = timeline_WRITE };
+  FILE* stream = fopencookie((void*)(intptr_t)fd, "w", io);
+  ASSERT( stream );
+  struct stat st;
+  if (like == stderr)
+    setvbuf(stream, NULL, _IONBF, 0);
+  else if (isatty(fd))
+    setvbuf(stream, NULL, _IOLBF, BUFSIZ);
+  else
+    {
+      // glibc ignores the size unless it is given the buffer too
+      size_t size = !fstat(fd, &st) && st.st_blksize > 0 ? (size_t)st.st_blksize : BUFSIZ;
+      setvbuf(stream, malloc(size), _IOFBF, size);
+    }
+  return stream;
+}
+#endif
+
+static int timeline_CMP(void const * a, void const * b)
+/* Order timeline events by process, then by time. */
+{
+  struct TIMELINE_EVENT const * x = a, * y = b;
+  if (x->pid != y->pid) return x->pid < y->pid ? -1 : 1;
+  return x->ns < y->ns ? -1 : x->ns > y->ns;
+}
+
+void timeline_JSON(void)
+/* Write the :trace timeline read from stdin to stdout as a Chrome
+   trace, a track per process, with a counter of the bytes each has
+   written to its stream that no write syscall has taken yet. */
+{
+#ifdef _WIN32
+  _setmode(_fileno(stdin), _O_BINARY);
+#endif
+  struct TIMELINE head;
+  ASSERT( fread(&head, sizeof(head), 1, stdin) == 1 );
+  ASSERT( !memcmp(head.magic, _TIMELINE_MAGIC, sizeof(head.magic)) );
+  uint64_t count = head.claimed < head.capacity ? head.claimed : head.capacity;
+  struct TIMELINE_EVENT* events = malloc((count+1)*sizeof(*events)); ASSERT(events);
+  count = fread(events, sizeof(*events), count, stdin);
+  qsort(events, count, sizeof(*events), timeline_CMP);
+
+  printf("{\"displayTimeUnit\":\"ns\",\"otherData\":{\"events\":%llu,\"dropped\":%llu},"
+	 "\"traceEvents\":[\n", (unsigned long long)count,
+	 (unsigned long long)(head.claimed - count));
+  char const * sep = "";
+  int32_t pid = 0; long long held = 0; bool named = false;
+  for (uint64_t i=0;i<count;i++)
+    {
+      struct TIMELINE_EVENT const * ev = &events[i];
+      if (!ev->kind) continue;
+      if (ev->pid != pid || !i) { pid = ev->pid; held = 0; named = false; }
+      double ts = ev->ns/1e3, dur = ev->dur/1e3;
+#define _EV(NAME, PH, FS, ...)						\
+      { printf("%s{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f" FS "}", \
+	       sep, NAME, PH, pid, pid, ts __VA_OPT__(,) __VA_ARGS__); sep = ",\n"; }
+      switch (ev->kind)
+	{
+	case eEV_START:
+	  if (!named)
+	    _EV("process_name", "M", ",\"args\":{\"name\":\"%s %d\"}",
+		ev->aux == 'P' ? "parent" : "child", pid);
+	  named = true;
+	  _EV("start", "i", ",\"s\":\"p\"");
+	  break;
+	case eEV_SPAWN:
+	  _EV("spawn", "X", ",\"dur\":%.3f,\"args\":{\"child\":%lld,\"stderr\":%d,\"pool\":%s}",
+	      dur, (long long)ev->bytes, ev->fd, ev->aux == 'p' ? "true" : "false");
+	  break;
+	case eEV_SETVBUF:
+	  _EV("setvbuf", "i", ",\"s\":\"t\",\"args\":{\"fd\":%d,\"mode\":\"%s\",\"size\":%lld}",
+	      ev->fd, ev->aux == 'n' ? "_IONBF" : ev->aux == 'l' ? "_IOLBF" : "_IOFBF",
+	      (long long)ev->bytes);
+	  break;
+	case eEV_WRITE:
+	case eEV_FLUSH:
+	  _EV(ev->kind == eEV_WRITE ? "stream-write" : "write-syscall", "X",
+	      ",\"dur\":%.3f,\"args\":{\"fd\":%d,\"bytes\":%lld}",
+	      dur, ev->fd, (long long)ev->bytes);
+	  // taken in by the stream as it starts, out by the syscall once done
+	  held += ev->kind == eEV_WRITE ? ev->bytes : -ev->bytes;
+	  if (held < 0) held = 0;
+	  if (ev->kind == eEV_FLUSH) ts += dur;
+	  _EV("stream-buffered", "C", ",\"args\":{\"bytes\":%lld}", held);
+	  break;
+	case eEV_READ:
+	  _EV("read", "X", ",\"dur\":%.3f,\"args\":{\"fd\":%d,\"bytes\":%lld}",
+	      dur, ev->fd, (long long)ev->bytes);
+	  break;
+	case eEV_EXIT:
+	  _EV("exit", "i", ",\"s\":\"p\"");
+	  break;
+	}
+#undef _EV
+      if (!(i & 0xffff)) _KICK();
+    }
+  printf("\n]}\n");
+  free(events);
+}
+
+#ifdef _WIN32
+void pipe_PROBE(int pipe_size)
+{
+  (void) pipe_size;
+  RPT(":probe-pipe-capacity :unsupported-on-this-platform\n");
+}
+#else
+/* a thread of the :probe-pipe-capacity atomicity check */
+struct PROBE_WRITER {
+  int fd;
+  char fill;
+  int record_len, records;
+};
+
+static void* probe_WRITE(void* arg)
+/* Write the records of the PROBE_WRITER in ARG, filled with its char,
+   one write() each. */
+{
+  struct PROBE_WRITER* pw = arg;
+  char* record = malloc(pw->record_len); ASSERT(record);
+  memset(record, pw->fill, pw->record_len);
+  for (int r=0;r<pw->records;r++) write_ALL(pw->fd, record, pw->record_len);
+  free(record);
+  return NULL;
+}
+
+static int probe_TORN(int pipe_size, int record_len, int records)
+/* Have two threads write RECORDS of RECORD-LEN bytes, each filled
+   with a char of its own, to a _pipe() of PIPE-SIZE at the same time.
+   Return how many of the records read back have both chars in them.
+*/
+{
+  enum { READ, WRITE };
+  int pfds[2];
+  ASSERT( !pipe_OPEN(pfds, pipe_size) );
+  struct PROBE_WRITER pws[2] = { { pfds[WRITE], 'a', record_len, records },
+				 { pfds[WRITE], 'b', record_len, records } };
+  pthread_t threads[2];
+  for (int t=0;t<2;t++)
+    ASSERT( !pthread_create(&threads[t], NULL, probe_WRITE, &pws[t]) );
+
+  char* record = malloc(record_len); ASSERT(record);
+  int torn = 0;
+  for (int r=0;r<2*records;r++)
+    {
+      for (int got=0;got<record_len;)
+	{
+	  int read = _read(pfds[READ], record+got, record_len-got);
+	  ASSERT( read > 0 );
+	  got += read;
+	}
+      torn += memchr(record, record[0]=='a' ? 'b' : 'a', record_len) != NULL;
+      _KICK();
+    }
+  for (int t=0;t<2;t++) pthread_join(threads[t], NULL);
+  free(record);
+  _close(pfds[READ]);
+  _close(pfds[WRITE]);
+  return torn;
+}
+
+void pipe_PROBE(int pipe_size)
+/* Create a _pipe() of PIPE-SIZE and report the capacity the kernel
+   granted and how many bytes it takes to fill it with non-blocking
+   writes, first of PIPE_BUF bytes and then of single bytes, none of
+   which should be partial.
+
+   Then check that records of PIPE_BUF bytes written to the pipe by
+   two threads at the same time come out in one piece, unlike records
+   of four times that.
+*/
+{
+  long max_size = -1;
+  FILE* max = fopen("/proc/sys/fs/pipe-max-size", "r");
+  if (max)
+    {
+      if (fscanf(max, "%ld", &max_size) != 1) max_size = -1;
+      fclose(max);
+    }
+
+  enum { READ, WRITE };
+  int pfds[2];
+  ASSERT( !pipe_OPEN(pfds, pipe_size) );
+  int granted = pipe_CAPACITY(pfds[READ]);
+  int flags = fcntl(pfds[WRITE], F_GETFL);
+  ASSERT( fcntl(pfds[WRITE], F_SETFL, flags | O_NONBLOCK) != -1 );
+
+  char chunk[PIPE_BUF];
+  memset(chunk, '$', sizeof(chunk));
+  int const lens[] = { PIPE_BUF, 1 };
+  long long filled = 0; int partial = 0;
+  for (int l=0;l<2;l++)
+    for (;;)
+      {
+	ssize_t wrote = write(pfds[WRITE], chunk, lens[l]);
+	if (wrote == -1 && errno == EAGAIN) break;
+	ASSERT( wrote > 0 );
+	partial += wrote != lens[l];
+	filled += wrote;
+      }
+  _close(pfds[READ]);
+  _close(pfds[WRITE]);
+
+  RPT(":probe-pipe-capacity :pipe-size %d :pipe-max-size %ld :granted %d :filled %lld"
+      " :partial-writes %d\n", pipe_size, max_size, granted, filled, partial);
+
+  int const records = 256;
+  for (int m=1;m<=4;m*=4)
+    RPT(":pipe-buf-atomicity :pipe-size %d :pipe-buf %d :record-bytes %d :records %d"
+	" :torn %d\n", pipe_size, PIPE_BUF, m*PIPE_BUF, 2*records,
+	probe_TORN(pipe_size, m*PIPE_BUF, records));
+}
+#endif
+
+#ifdef _WIN32
+void stdio_PROBE(enum e_args via, bool to_stdout)
+{
+  (void) via; (void) to_stdout;
+  RPT(":probe-stdio-buffer :unsupported-on-this-platform\n");
+}
+#else
+/* how long the parent waits for a probe's write to arrive, and how
+   long the child waits before exiting, so that arriving means
+   flushed by the write itself rather than at exit */
+#define _PROBE_DEADLINE_MS 50
+#define _PROBE_HOLD_MS 500
+
+static int stdio_ARRIVES(enum e_args via, bool to_stdout, enum e_args write_type,
+			 int write_count)
+/* Spawn a child that writes WRITE-COUNT '$' chars with WRITE-TYPE to
+   its stdout (TO-STDOUT is set) or stderr, redirected to a _pipe()
+   (VIA is `eVIA_PIPE'), a socket (`eVIA_SOCK'), a pseudo terminal
+   (`eVIA_PTY') or a file (`eVIA_FILE'), and then holds on.
+
+   Return the number of bytes that arrived within the deadline, the
+   child is killed after that.
+*/
+{
+  char cmdargs[80];
+  snprintf(cmdargs, sizeof(cmdargs), ":to-stderr :quiet%s :hold %d %s %d",
+	   to_stdout ? " :stdout" : "", _PROBE_HOLD_MS,
+	   write_type==eWRITE_NL ? ":write-nl" : ":write", write_count);
+
+  enum { READ, WRITE };
+  int fd = -1;
+  child_t child;
+  if (via == eVIA_SOCK)
+    {
+      SOCKET sfds[2];
+      socket_PAIR(sfds);
+      child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+      closesocket(sfds[WRITE]);
+      fd = sfds[READ];
+    }
+  else if (via == eVIA_FILE)
+    {
+      char path[] = "/tmp/stest-probe-XXXXXX";
+      int wfd = mkstemp(path);
+      ASSERT( wfd != -1 );
+      unlink(path);
+      fd = dup(wfd); ASSERT( fd != -1 );
+      fhandle_t write_handle = fd_INHERITABLE (wfd);
+      child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+      handle_CLOSE(write_handle);
+    }
+  else
+    {
+      int pfds[2];
+      int rc = via == eVIA_PTY ? pty_OPEN (pfds) : pipe_OPEN (pfds, 0);
+      ASSERT( rc == 0 );
+      fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+      child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+      handle_CLOSE(write_handle);
+      fd = pfds[READ];
+    }
+
+  int arrived = 0;
+  uint64_t deadline = clock_NS() + _PROBE_DEADLINE_MS*1000000ULL;
+  for (uint64_t now=clock_NS();!arrived && now<deadline;now=clock_NS())
+    if (via == eVIA_FILE)
+      {
+	// a file is always readable, watch its size instead
+	struct stat st;
+	ASSERT( fstat(fd, &st) == 0 );
+	arrived = st.st_size;
+	struct timespec ts = { 0, 200000 };
+	if (!arrived) nanosleep(&ts, NULL);
+      }
+    else
+      {
+	struct pollfd pfd = { fd, POLLIN, 0 };
+	int ready = poll(&pfd, 1, (deadline-now+999999)/1000000);
+	if (ready <= 0) continue;
+	char chunk[1<<16];
+	int flags = fcntl(fd, F_GETFL);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	int read = _read(fd, chunk, sizeof(chunk));
+	if (read > 0) arrived = read;
+	else if (read == 0 || errno != EAGAIN) break;
+      }
+
+  kill(child, SIGKILL);
+  child_WAIT(child);
+  if (via == eVIA_SOCK) closesocket(fd); else _close(fd);
+  _KICK();
+  return arrived;
+}
+
+void stdio_PROBE(enum e_args via, bool to_stdout)
+/* Find out how a child buffers its stdout (TO-STDOUT is set) or
+   stderr when redirected to VIA (see `stdio_ARRIVES'): unbuffered
+   when a single char arrives straight away, line buffered when it
+   arrives with a new line. Otherwise, and for line buffering as well,
+   binary search the smallest write that arrives, which is the
+   effective size of the buffer.
+*/
+{
+  char const * mode = "unbuf";
+  int size = 0, probes = 1;
+  int first_flush = stdio_ARRIVES(via, to_stdout, eWRITE, 1);
+  if (!first_flush)
+    {
+      probes += 2;
+      mode = stdio_ARRIVES(via, to_stdout, eWRITE_NL, 1) ? "lnbuf" : "flbuf";
+      // LOW never arrives, HIGH does
+      int low = 1, high = 1<<20;
+      if (!stdio_ARRIVES(via, to_stdout, eWRITE, high))
+	{
+	  mode = "held"; size = -1;
+	}
+      else
+	{
+	  while (high - low > 1)
+	    {
+	      int mid = low + (high-low)/2;
+	      if (stdio_ARRIVES(via, to_stdout, eWRITE, mid)) high = mid; else low = mid;
+	      probes++;
+	    }
+	  size = high;
+	  first_flush = stdio_ARRIVES(via, to_stdout, eWRITE, size);
+	  probes++;
+	}
+    }
+  RPT(":probe-stdio-buffer :transport %s :stream %s :mode %s :buffer-size %d"
+      " :first-flush-bytes %d :probes %d\n",
+      via==eVIA_PIPE ? "pipe" : via==eVIA_SOCK ? "sock" : via==eVIA_PTY ? "pty" : "file",
+      to_stdout ? "stdout" : "stderr", mode, size, first_flush, probes);
+}
+#endif
+
+/* The records of a verified stream. Each is RECORD-LEN bytes, a
+   multiple of 8, of a `RECORD_HEAD' followed by payload words that
+   are a function of the sequence number, so that the checksum of a
+   record is known from its sequence number alone. */
+#define _RECORD_MAGIC 0x43455253u   /* "SREC" */
+#define _RECORD_K 0x9E3779B97F4A7C15ULL
+struct RECORD_HEAD {
+  uint32_t magic;
+  uint32_t len;         /* of the whole record */
+  uint64_t seq;
+  uint64_t sum;         /* of the payload words */
+};
+
+/* wide enough for the compiler to use the vector unit, whichever it
+   is */
+typedef uint64_t v4u64 __attribute__((vector_size(32)));
+
+static uint64_t record_SUM(uint64_t seq, int words)
+/* Return the checksum of a payload of WORDS words of record SEQ. */
+{
+  return (uint64_t)words*seq*_RECORD_K + (uint64_t)words*(words-1)/2;
+}
+
+static void record_FILL(char* record, int record_len, uint64_t seq)
+/* Write record SEQ of RECORD-LEN bytes to RECORD. */
+{
+  int words = (record_len - (int)sizeof(struct RECORD_HEAD))/8;
+  struct RECORD_HEAD head = { _RECORD_MAGIC, record_len, seq, record_SUM(seq, words) };
+  memcpy(record, &head, sizeof(head));
+  char* payload = record + sizeof(head);
+  uint64_t base = seq*_RECORD_K;
+  v4u64 w = { base, base+1, base+2, base+3 }, step = { 4, 4, 4, 4 };
+  int i = 0;
+  for (;i+4<=words;i+=4,w+=step) memcpy(payload+8*i, &w, sizeof(w));
+  for (;i<words;i++) { uint64_t v = base+i; memcpy(payload+8*i, &v, 8); }
+}
+
+static bool record_VALID(char const * record, int record_len, uint64_t* seq)
+/* Return true if RECORD of RECORD-LEN bytes is whole, and its
+   sequence number in SEQ. The payload is summed four words at a
+   time. */
+{
+  struct RECORD_HEAD head;
+  memcpy(&head, record, sizeof(head));
+  if (head.magic != _RECORD_MAGIC || head.len != (uint32_t)record_len) return false;
+  int words = (record_len - (int)sizeof(head))/8;
+  if (head.sum != record_SUM(head.seq, words)) return false;
+
+  char const * payload = record + sizeof(head);
+  v4u64 acc = { 0, 0, 0, 0 };
+  int i = 0;
+  for (;i+4<=words;i+=4)
+    {
+      v4u64 w; memcpy(&w, payload+8*i, sizeof(w));
+      acc += w;
+    }
+  uint64_t sum = acc[0] + acc[1] + acc[2] + acc[3];
+  for (;i<words;i++) { uint64_t v; memcpy(&v, payload+8*i, 8); sum += v; }
+  *seq = head.seq;
+  return sum == head.sum;
+}
+
+void records_WRITE(struct SHM_RING* ring, int record_len, long long count)
+/* Write COUNT records of RECORD-LEN bytes, numbered from 0, to stderr
+   or to RING when set, in chunks of about 64KB generated on the heap
+   as they go. */
+{
+  int per_chunk = (1<<16)/record_len > 0 ? (1<<16)/record_len : 1;
+  char* chunk = malloc((size_t)per_chunk*record_len); ASSERT(chunk);
+  _BLOCKING(ring ? "shm-write" : "write", ring ? -1 : STDERR_FILENO, true, 0);
+  for (long long seq=0;seq<count;)
+    {
+      int n = count-seq < per_chunk ? (int)(count-seq) : per_chunk;
+      for (int r=0;r<n;r++) record_FILL(chunk+(size_t)r*record_len, record_len, seq+r);
+      int len = n*record_len;
+      for (int done=0;done<len;)
+	{
+	  uint64_t before = _TIMELINE ? clock_NS() : 0;
+	  int wrote = ring ? shm_WRITE(ring, chunk+done, len-done)
+	    : _write(STDERR_FILENO, chunk+done, len-done);
+	  if (wrote <= 0) { free(chunk); return; }
+	  if (_TIMELINE && !ring)
+	    timeline_ADD(eEV_FLUSH, before, clock_NS()-before, STDERR_FILENO, wrote, 0);
+	  done += wrote;
+	  _PROGRESS(seq*record_len+done);
+	}
+      seq += n;
+      _KICK();
+    }
+  free(chunk);
+}
+
+/* the state of the verification of a stream of records */
+struct STREAM_CHECK {
+  int record_len;
+  uint64_t count;          /* records sent */
+  uint8_t* seen;           /* bitmap of the records received */
+  uint64_t next;           /* the sequence number expected next */
+  uint64_t received, duplicated, reordered, torn;
+  long long skipped;       /* bytes not part of any whole record */
+  bool in_sync;
+  char* pending; int pending_len, pending_size;
+  uint64_t check_ns;
+};
+
+static void stream_SEEN(struct STREAM_CHECK* sc, uint64_t seq)
+{
+  if (seq >= sc->count) { sc->torn++; return; }
+  uint8_t bit = 1<<(seq&7);
+  if (sc->seen[seq>>3] & bit) { sc->duplicated++; return; }
+  sc->seen[seq>>3] |= bit;
+  sc->received++;
+  if (seq < sc->next) sc->reordered++;
+  else sc->next = seq+1;
+}
+
+static int stream_SCAN(struct STREAM_CHECK* sc, char const * data, int len)
+/* Check the whole records at the start of DATA of LEN bytes, skipping
+   a byte at a time past anything that is not a whole record until
+   back in sync. Return the bytes consumed. */
+{
+  int at = 0;
+  uint64_t seq;
+  while (len - at >= sc->record_len)
+    {
+      if (record_VALID(data+at, sc->record_len, &seq))
+	{
+	  stream_SEEN(sc, seq);
+	  at += sc->record_len;
+	  sc->in_sync = true;
+	  continue;
+	}
+      if (sc->in_sync) sc->torn++;
+      sc->in_sync = false;
+      sc->skipped++; at++;
+    }
+  return at;
+}
+
+static void stream_CHECK(struct STREAM_CHECK* sc, char const * data, int len)
+/* Check the LEN bytes of DATA, the next ones of the stream. Records
+   split between calls are put together in SC's pending buffer. */
+{
+  uint64_t start = clock_NS();
+  if (sc->pending_len + len > sc->pending_size)
+    {
+      sc->pending_size = sc->pending_len + len;
+      sc->pending = realloc(sc->pending, sc->pending_size); ASSERT(sc->pending);
+    }
+  if (!sc->pending_len)
+    {
+      int used = stream_SCAN(sc, data, len);
+      memcpy(sc->pending, data+used, len-used);
+      sc->pending_len = len-used;
+    }
+  else
+    {
+      memcpy(sc->pending+sc->pending_len, data, len);
+      sc->pending_len += len;
+      int used = stream_SCAN(sc, sc->pending, sc->pending_len);
+      memmove(sc->pending, sc->pending+used, sc->pending_len-used);
+      sc->pending_len -= used;
+    }
+  sc->check_ns += clock_NS()-start;
+}
+
+void stream_VERIFY(enum e_args via, int mbytes, int record_len, enum e_args reader)
+/* Spawn a child process that writes MBYTES of records of RECORD-LEN
+   bytes (see `records_WRITE') to its stderr, redirected to a _pipe()
+   (VIA is `eVIA_PIPE'), a socket (`eVIA_SOCK') or a pseudo terminal
+   (`eVIA_PTY'), or to a shared memory ring (`eVIA_SHM'). The parent
+   reads them with the READER engine (see `reader_OPEN') and checks
+   every record as it arrives.
+
+   Reports the records lost, duplicated, out of order or torn (not
+   whole, e.g. mixed with other bytes), the bytes skipped to get back
+   in sync, the throughput and the rate of the check alone.
+*/
+{
+  long long count = ((long long)mbytes<<20) / record_len;
+  char cmdargs[80];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs),
+			      ":to-stderr :quiet :records %d %lld", record_len, count);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+
+  enum { READ, WRITE };
+  bool sock = via == eVIA_SOCK;
+  intptr_t read_handle = -1;
+  struct SHM_RING* ring = NULL;
+  uint64_t start = clock_NS();
+  child_t child;
+  switch (via)
+    {
+    case eVIA_PIPE: case eVIA_PTY:
+      {
+	int pfds[2];
+	int rc = via == eVIA_PTY ? pty_OPEN (pfds) : pipe_OPEN (pfds, 0);
+	ASSERT( rc == 0 );
+#ifndef _WIN32
+	// the records are binary, which the line discipline would rewrite,
+	// e.g. each \n to \r\n with ONLCR
+	if (via == eVIA_PTY)
+	  {
+	    struct termios raw;
+	    rc = tcgetattr(pfds[WRITE], &raw); ASSERT( rc == 0 );
+	    cfmakeraw(&raw);
+	    rc = tcsetattr(pfds[WRITE], TCSANOW, &raw); ASSERT( rc == 0 );
+	  }
+#endif
+	fhandle_t write_handle = fd_INHERITABLE (pfds[WRITE]);
+	child = child_SPAWN(cmdargs, write_handle); ASSERT(child);
+	handle_CLOSE(write_handle);
+	read_handle = pfds[READ];
+	break;
+      }
+    case eVIA_SOCK:
+      {
+	SOCKET sfds[2];
+	socket_PAIR(sfds);
+	child = child_SPAWN(cmdargs, (fhandle_t)sfds[WRITE]); ASSERT(child);
+	closesocket(sfds[WRITE]);
+	read_handle = sfds[READ];
+	break;
+      }
+    default:
+      ASSERT( via == eVIA_SHM );
+      child = shm_SPAWN(cmdargs, &ring);
+    }
+
+  struct STREAM_CHECK sc;
+  memset(&sc, 0, sizeof(sc));
+  sc.record_len = record_len; sc.count = count; sc.in_sync = true;
+  sc.seen = calloc((count+7)/8, 1); ASSERT(sc.seen);
+
+  int chunk_size = 1<<16;
+  char* chunk = malloc(chunk_size); ASSERT(chunk);
+  long long got = 0;
+  struct READER rd;
+  if (!ring) reader_OPEN(&rd, reader, read_handle, sock);
+  for (;;)
+    {
+      int read = ring ? shm_READ(ring, chunk, chunk_size)
+	: reader_READ(&rd, chunk, chunk_size);
+      if (read <= 0) break;
+      got += read;
+      stream_CHECK(&sc, chunk, read);
+      _KICK();
+    }
+  if (ring) shm_CLOSE(ring, false);
+  else
+    {
+      reader_CLOSE(&rd);
+      if (sock) closesocket((SOCKET)read_handle); else _close((int)read_handle);
+    }
+  free(chunk);
+  child_WAIT(child);
+  uint64_t elapsed = clock_NS()-start;
+
+  // an incomplete record at the end is torn as well
+  if (sc.pending_len) { sc.torn++; sc.skipped += sc.pending_len; }
+
+  RPT(":verify-stream :transport %s :reader %s :record-bytes %d :records %lld"
+      " :received %llu :lost %llu :duplicated %llu :reordered %llu :torn %llu"
+      " :skipped-bytes %lld :mbytes %.1f :mb-per-s %.1f :check-mb-per-s %.1f\n",
+      via==eVIA_PIPE ? "pipe" : sock ? "sock" : via==eVIA_PTY ? "pty" : "shm",
+      reader_NAME(reader), record_len, count,
+      (unsigned long long)sc.received, (unsigned long long)(count - sc.received),
+      (unsigned long long)sc.duplicated, (unsigned long long)sc.reordered,
+      (unsigned long long)sc.torn, sc.skipped, got/1048576.0,
+      got/1048576.0/(elapsed/1e9),
+      sc.check_ns ? got/1048576.0/(sc.check_ns/1e9) : 0.0);
+  free(sc.pending);
+  free(sc.seen);
+}
+
+#ifdef _WIN32
+void spawn_BENCH(enum e_args spawner, int runs, int rss_mbytes)
+{
+  (void) spawner; (void) runs; (void) rss_mbytes;
+  RPT(":bench-spawn :unsupported-on-this-platform\n");
+}
+#else
+/* what the child of a :bench-spawn run executes, see `spawn_CLONED' */
+struct SPAWN_EXEC {
+  char const * cmd; char** cargv; char** cenvp;
+  int err_fd;
+};
+
+static int spawn_CLONED(void* _exec)
+/* The entry point of a child clone()d with CLONE_VM, sharing our
+   memory until it execs. */
+{
+  struct SPAWN_EXEC const * exec = _exec;
+  dup2(exec->err_fd, STDERR_FILENO);
+  execve(exec->cmd, exec->cargv, exec->cenvp);
+  _exit(127);
+}
+
+static long rss_KBYTES(void)
+/* Return the resident set size of this process in KB. */
+{
+  long pages = 0, resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm)
+    {
+      if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+      fclose(statm);
+    }
+  return resident * (sysconf(_SC_PAGESIZE)/1024);
+}
+
+void spawn_BENCH(enum e_args spawner, int runs, int rss_mbytes)
+/* Spawn RUNS child processes with SPAWNER, each writing a single '$'
+   to its stderr, a _pipe(), after growing this process by RSS-MBYTES
+   of touched memory. SPAWNER is one of fork() and execve() in the
+   child (`eSPAWN_FORK'), vfork() (`eSPAWN_VFORK'), posix_spawn()
+   (`eSPAWN_POSIX') or clone() with CLONE_VM|CLONE_VFORK
+   (`eSPAWN_CLONE').
+
+   Reports the distribution of the time the call took to return to
+   the parent, and of the time until the child's first byte arrived.
+*/
+{
+  char const * name =
+    spawner==eSPAWN_FORK ? "fork" : spawner==eSPAWN_VFORK ? "vfork" :
+    spawner==eSPAWN_POSIX ? "posix-spawn" : "clone";
+
+  // touched, so that the pages are mapped in and have to be copied
+  // or shared on fork()
+  size_t ballast_size = (size_t)rss_mbytes<<20;
+  char* ballast = NULL;
+  if (ballast_size)
+    {
+      ballast = mmap(NULL, ballast_size, PROT_READ|PROT_WRITE,
+		     MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+      ASSERT( ballast != MAP_FAILED );
+      memset(ballast, '@', ballast_size);
+    }
+  long rss_kb = rss_KBYTES();
+
+  char cmd[PATH_MAX];
+  ssize_t cmd_len = readlink("/proc/self/exe", cmd, sizeof(cmd)-1);
+  ASSERT( cmd_len > 0 );
+  cmd[cmd_len] = 0;
+  char* cargv[] = { cmd, ":to-stderr", ":quiet", ":write", "1", NULL };
+
+  // as in `child_SPAWN', our environment with the mutex ID replaced
+  char const * id_var = "STEST_MX_ID=";
+  int envc = 0; while (environ[envc]) envc++;
+  char* cenvp[envc+2]; int cenvc = 0;
+  for (int i=0;i<envc;i++)
+    if (strncmp(environ[i], id_var, strlen(id_var))) cenvp[cenvc++] = environ[i];
+  int id_size = 1+snprintf(NULL, 0, "%s%s", id_var, _MX_ID);
+  char id[id_size];
+  snprintf(id, id_size, "%s%s", id_var, _MX_ID);
+  cenvp[cenvc++] = id;
+  cenvp[cenvc] = NULL;
+
+  size_t stack_size = 1<<16;
+  char* stack = NULL;
+  if (spawner == eSPAWN_CLONE)
+    {
+      stack = mmap(NULL, stack_size, PROT_READ|PROT_WRITE,
+		   MAP_PRIVATE|MAP_ANONYMOUS|MAP_STACK, -1, 0);
+      ASSERT( stack != MAP_FAILED );
+    }
+
+  struct HISTOGRAM* call = calloc(1, sizeof(*call)); ASSERT(call);
+  struct HISTOGRAM* first = calloc(1, sizeof(*first)); ASSERT(first);
+  enum { READ, WRITE };
+  for (int r=0;r<runs;r++)
+    {
+      int pfds[2];
+      int rc = pipe_OPEN(pfds, 0);
+      ASSERT( rc == 0 );
+
+      pid_t pid = -1;
+      uint64_t start = clock_NS();
+      switch (spawner)
+	{
+	case eSPAWN_FORK: case eSPAWN_VFORK:
+	  pid = spawner==eSPAWN_FORK ? fork() : vfork();
+	  if (pid == 0)
+	    {
+	      // only async-signal-safe calls past this point
+	      dup2(pfds[WRITE], STDERR_FILENO);
+	      execve(cmd, cargv, cenvp);
+	      _exit(127);
+	    }
+	  break;
+	case eSPAWN_POSIX:
+	  {
+	    posix_spawn_file_actions_t fa;
+	    posix_spawn_file_actions_init(&fa);
+	    posix_spawn_file_actions_adddup2(&fa, pfds[WRITE], STDERR_FILENO);
+	    if (posix_spawn(&pid, cmd, &fa, NULL, cargv, cenvp)) pid = -1;
+	    posix_spawn_file_actions_destroy(&fa);
+	    break;
+	  }
+	default:
+	  {
+	    ASSERT( spawner == eSPAWN_CLONE );
+	    struct SPAWN_EXEC exec = { cmd, cargv, cenvp, pfds[WRITE] };
+	    pid = clone(spawn_CLONED, stack+stack_size,
+			CLONE_VM|CLONE_VFORK|SIGCHLD, &exec);
+	  }
+	}
+      uint64_t returned = clock_NS();
+      ASSERT( pid != -1 );
+      _close(pfds[WRITE]);
+
+      char c;
+      int read;
+      while ((read = _read(pfds[READ], &c, 1)) == -1 && errno == EINTR) continue;
+      uint64_t arrived = clock_NS();
+      ASSERT( read == 1 );
+      _close(pfds[READ]);
+      while (waitpid(pid, NULL, 0) == -1 && errno == EINTR) continue;
+
+      hist_ADD(call, returned-start);
+      hist_ADD(first, arrived-start);
+      _KICK();
+    }
+
+  RPT(":bench-spawn :spawner %s :rss-mbytes %d :rss-kbytes %ld :runs %d\n",
+      name, rss_mbytes, rss_kb, runs);
+  hist_RPT(call, "spawn-return");
+  hist_RPT(first, "spawn-first-byte");
+
+  free(first);
+  free(call);
+  if (stack) munmap(stack, stack_size);
+  if (ballast) munmap(ballast, ballast_size);
+}
+#endif
+
+#ifdef _WIN32
+void pool_OPEN(int workers)
+{
+  (void) workers;
+  RPT(":pool :unsupported-on-this-platform\n");
+}
+#else
+/* a pre-forked child process of the :pool, see `pool_OPEN' */
+struct POOL_WORKER {
+  pid_t pid;
+  int control;  /* our end of its control channel */
+  bool busy;    /* with a job not waited for yet */
+};
+
+/* what a worker replies with once done with a job */
+struct POOL_DONE {
+  uint64_t cpu_ns;
+  int64_t write_syscalls;
+};
+
+static void pool_WORK(int control)
+/* The loop of a pool worker: receive a job, the :to-stderr command
+   line arguments along with the handle to use as stderr, over the
+   CONTROL channel, carry it out and reply with a `POOL_DONE'. Exit
+   when the channel is closed. */
+{
+  _PID = getpid(); _RL = "CHILD";
+  int null = open("/dev/null", O_WRONLY|O_CLOEXEC);
+  ASSERT( null != -1 );
+  // the watchdog thread is not forked along, a worker gets one of its
+  // own with a child's deadline, for a job stuck writing to end as a
+  // spawned child would
+  _EXIT_US /= 2;
+  pthread_t watchdog;
+  ASSERT( pthread_create(&watchdog, NULL, _EXIT, &_EXIT_US) == 0 );
+  for (;;)
+    {
+      // idle until the next job
+      _BLOCKING("pool-idle", -1, false, 0);
+      struct pollfd pfd = { control, POLLIN, 0 };
+      while (poll(&pfd, 1, 100) == 0) _KICK();
+      _KICK();
+
+      // the length of the next job, which has no limit of its own
+      ssize_t size;
+      while ((size = recv(control, NULL, 0, MSG_PEEK|MSG_TRUNC)) == -1
+	     && errno == EINTR) continue;
+      if (size <= 0) _exit(0);
+
+      char* cmdargs = malloc(size+1); ASSERT(cmdargs);
+      union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof(int))]; } cm;
+      struct iovec iov = { cmdargs, size };
+      struct msghdr mh; memset(&mh, 0, sizeof(mh));
+      mh.msg_iov = &iov; mh.msg_iovlen = 1;
+      mh.msg_control = cm.buf; mh.msg_controllen = sizeof(cm.buf);
+      while ((size = recvmsg(control, &mh, MSG_CMSG_CLOEXEC)) == -1
+	     && errno == EINTR) continue;
+      ASSERT( size > 0 );
+      cmdargs[size] = 0;
+      struct cmsghdr* ch = CMSG_FIRSTHDR(&mh);
+      ASSERT( ch && ch->cmsg_type == SCM_RIGHTS );
+      int err_fd; memcpy(&err_fd, CMSG_DATA(ch), sizeof(int));
+      ASSERT( dup2(err_fd, STDERR_FILENO) != -1 );
+      _close(err_fd);
+      _CM = stderr_MARK();
+      timeline_ADD(eEV_START, clock_NS(), 0, -1, 0, 'C');
+
+      // there are no quoted arguments, split at the spaces
+      int cargc = 1;
+      for (char const * c=cmdargs;*c;c++) cargc += *c == ' ';
+      char const ** cargv = calloc(cargc+2, sizeof(char*)); ASSERT(cargv);
+      cargc = 0;
+      cargv[cargc++] = "stest";
+      for (char* tok=strtok(cmdargs, " "); tok; tok=strtok(NULL, " "))
+	cargv[cargc++] = tok;
+      int* args = calloc(cargc, sizeof(int)); ASSERT(args);
+      ASSERT( args_PARSE(cargc, cargv, args) && args[1] == eTO_STDERR );
+      // it shares stdout with the parent
+      ASSERT( args[0] < 2 || args[2] != eSTDOUT );
+
+      _QUIET = args[2] == eQUIET;
+      if (!_QUIET) log_CMD(cargc, cargv);
+      uint64_t cpu_start = cpu_NS();
+      int64_t syscw_start = io_SYSCW(_PID);
+      char* buffer = NULL;
+      to_stderr(args, &buffer);
+
+      // back to the default, unbuffered, stderr pointing nowhere, for
+      // the reader to see the end of the stream. Any :trace stream
+      // standing in for stderr, or iostream, is flushed too.
+      fflush(NULL);
+      iostream_FLUSH();
+      setvbuf(stderr, NULL, _IONBF, 0);
+      free(buffer);
+      dup2(null, STDERR_FILENO);
+
+      struct POOL_DONE done = { cpu_NS()-cpu_start, -1 };
+      int64_t syscw = io_SYSCW(_PID);
+      if (syscw != -1 && syscw_start != -1) done.write_syscalls = syscw-syscw_start;
+      ASSERT( send(control, &done, sizeof(done), MSG_NOSIGNAL) == sizeof(done) );
+      free(args);
+      free(cargv);
+      free(cmdargs);
+    }
+}
+
+void pool_OPEN(int workers)
+/* Fork WORKERS child processes, ahead of any experiment so that they
+   hold on to none of its handles, to run the :to-stderr jobs
+   `child_SPAWN' is given thereafter in place of new instances of the
+   program (see `pool_SPAWN'). They exit once we do.
+*/
+{
+  _POOL = calloc(workers, sizeof(struct POOL_WORKER)); ASSERT(_POOL);
+  for (int w=0;w<workers;w++)
+    {
+      int sv[2];
+      ASSERT( !socketpair(AF_UNIX, SOCK_SEQPACKET|SOCK_CLOEXEC, 0, sv) );
+      pid_t pid = fork();
+      ASSERT( pid != -1 );
+      if (pid == 0)
+	{
+	  // the channels of the others must close when we exit
+	  for (int o=0;o<w;o++) _close(_POOL[o].control);
+	  _close(sv[0]);
+	  pool_WORK(sv[1]);
+	}
+      _close(sv[1]);
+      _POOL[w].pid = pid; _POOL[w].control = sv[0];
+      _POOL_SIZE++;
+    }
+  RPT(":pool :workers %d\n", workers);
+}
+
+child_t pool_SPAWN(char const * cmdargs, fhandle_t err_handle)
+/* Hand the :to-stderr command line arguments CMDARGS and ERR-HANDLE
+   to use as stderr to an idle pool worker. Return the pid of the
+   worker, for `child_WAIT' or `child_REAP'. */
+{
+  struct POOL_WORKER* pw = NULL;
+  for (int w=0;w<_POOL_SIZE && !pw;w++) if (!_POOL[w].busy) pw = &_POOL[w];
+  if (!pw) RPT(":pool :workers %d :all-busy\n", _POOL_SIZE);
+  ASSERT( pw );
+
+  union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof(int))]; } cm;
+  memset(&cm, 0, sizeof(cm));
+  struct iovec iov = { (void*)cmdargs, strlen(cmdargs) };
+  struct msghdr mh; memset(&mh, 0, sizeof(mh));
+  mh.msg_iov = &iov; mh.msg_iovlen = 1;
+  mh.msg_control = cm.buf; mh.msg_controllen = sizeof(cm.buf);
+  struct cmsghdr* ch = CMSG_FIRSTHDR(&mh);
+  ch->cmsg_level = SOL_SOCKET; ch->cmsg_type = SCM_RIGHTS;
+  ch->cmsg_len = CMSG_LEN(sizeof(int));
+  memcpy(CMSG_DATA(ch), &err_handle, sizeof(int));
+  ssize_t sent;
+  while ((sent = sendmsg(pw->control, &mh, MSG_NOSIGNAL)) == -1 && errno == EINTR)
+    continue;
+  ASSERT( sent == (ssize_t)iov.iov_len );
+  _RPT_D(":pool/job :worker %d :cmd %s\n", (int)pw->pid, cmdargs);
+  pw->busy = true;
+  return pw->pid;
+}
+
+bool pool_WAIT(child_t child, struct CHILD_STATS* stats)
+/* When CHILD is a pool worker, wait for it to finish its job, keeping
+   the watchdog at bay, and fill in STATS, when set, with the resources
+   the job used. Return false when CHILD is not a pool worker.
+
+   A worker whose job made no progress for a child's deadline exits
+   (see `pool_WORK'), and is then reaped and never handed a job again.
+*/
+{
+  struct POOL_WORKER* pw = NULL;
+  for (int w=0;w<_POOL_SIZE && !pw;w++) if (_POOL[w].pid == child) pw = &_POOL[w];
+  if (!pw) return false;
+  ASSERT( pw->busy );
+
+  struct POOL_DONE done;
+  struct pollfd pfd = { pw->control, POLLIN, 0 };
+  while (poll(&pfd, 1, 100) != 1) _KICK();
+  ssize_t got;
+  while ((got = recv(pw->control, &done, sizeof(done), 0)) == -1 && errno == EINTR)
+    continue;
+  if (got == 0)
+    {
+      int status;
+      while (waitpid(pw->pid, &status, 0) == -1 && errno == EINTR) continue;
+      RPT(":pool :worker %d :exited %d\n", (int)pw->pid,
+	  WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status));
+      // still busy, for good
+      _close(pw->control);
+      pw->pid = 0;
+      done.cpu_ns = 0; done.write_syscalls = -1;
+    }
+  else
+    {
+      ASSERT( got == sizeof(done) );
+      pw->busy = false;
+    }
+  if (stats)
+    {
+      stats->cpu_ns = done.cpu_ns;
+      stats->write_syscalls = done.write_syscalls;
+    }
+  return true;
+}
+#endif
+
+#ifdef _WIN32
+void socket_BENCH(struct SOCK_OPTS const * opts, int runs, int mbytes, int write_count)
+{
+  (void) opts; (void) runs; (void) mbytes; (void) write_count;
+  RPT(":bench-socket :unsupported-on-this-platform\n");
+}
+#else
+void socket_BENCH(struct SOCK_OPTS const * opts, int runs, int mbytes, int write_count)
+/* With the child's stderr redirected to a socket pair of the kind and
+   with the options in OPTS (see `socket_PAIR'), measure the delay of
+   RUNS records of WRITE-COUNT '$' chars (see
+   `latency_to_child_stderr') and the throughput of MBYTES written in
+   chunks of WRITE-COUNT chars (see `throughput_BENCH').
+*/
+{
+  char const * kind =
+    opts->kind==eSOCK_PAIR ? "pair" : opts->kind==eSOCK_UNIX ? "unix" :
+    opts->kind==eSOCK_SEQPACKET ? "seqpacket" : "tcp";
+  RPT(":bench-socket :socket %s :sndbuf %d :rcvbuf %d :nodelay %s :cork %s :zerocopy %s\n",
+      kind, opts->sndbuf, opts->rcvbuf, opts->nodelay ? "on" : "off",
+      opts->cork ? "on" : "off", opts->zerocopy ? "on" : "off");
+
+  char cmdargs[64];
+  int cmdargs_size = snprintf(cmdargs, sizeof(cmdargs), ":to-stderr :quiet :stamp :write %d",
+			      write_count);
+  ASSERT(cmdargs_size < (int)sizeof(cmdargs));
+
+  struct SOCK_OPTS const defaults = _SOCK;
+  _SOCK = *opts;
+  latency_to_child_stderr(eVIA_SOCK, 0, runs, _STAMP_LEN+write_count, cmdargs,
+			  eREAD_BLOCKING);
+  throughput_BENCH(eVIA_SOCK, mbytes, write_count, 0, 0, 0, 0, eREAD_BLOCKING, 0, 0, 0, 0);
+  _SOCK = defaults;
+}
+#endif